@@ -1,5 +1,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "autopilot.h"
+#include "mcts.h"
+#include "shared_states.h"
+#include "snake_sim.h"
 #include <GL/glut.h>
 #include <math.h>
 #include <cstdio>
@@ -11,48 +15,23 @@
 
 using namespace std;
 
-struct Segment
-{
-    float x, z; // Position on ground plane
-};
-
-struct Apple
-{
-    float x, z;
-    bool active;
-};
-
-enum GameState
-{
-    PLAYING,
-    GAME_OVER
-};
-
-GameState gameState = PLAYING;
-
-
-enum Direction
-{
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT
-};
 const float APPLE_SIZE = 0.6f;
-const int MAX_APPLES = 3;
 
-struct Wall
-{
-    float x, z; // Center position
-    float w, d; // Width and depth
-};
+SnakeSim game;          // Game rules and state
+Direction nextDir = UP; // Latest arrow key, applied on the next tick
 
-Direction currentDir = UP;
-vector<Segment> snake = {{0, 0}, {0, 1}, {0, 2}}; // Initial snake
-vector<Apple> apples;// Active apples
-vector<Wall> walls;// Walls in the game
-int score = 0;
-int highScore = 0;
+// --autopilot: the BFS bot picks every move (attract mode). With
+// --autopilot mcts, tree search on every core does instead, thinking for
+// 100 ms of each 150 ms tick.
+BfsAutopilot<ClassicRules> autopilot;
+MctsAutopilot<ClassicRules> *searchAutopilot = NULL;
+bool autopilotOn = false;
+
+// --view mode: game is copied from another process's shared states
+// instead of being played here
+SharedStates viewed;
+int viewSlot = 0;
+int32_t viewedGame = -1;
 
 
 float rotateY = 0.0f;
@@ -128,219 +107,6 @@ GLuint loadTexture(const char *filename, bool flipVertically = true)
     return textureID;
 }
 
-//Apple Functions 
-void spawnApple()
-{
-    if (apples.size() >= MAX_APPLES)
-        return;
-
-    Apple newApple;
-
-    // Find valid position that isn't on snake, not on walls)
-    bool validPosition = false;
-    int attempts = 0;
-
-    while (!validPosition && attempts < 100)
-    {
-        // Random position within bounds keeping away from the edges
-        newApple.x = (rand() % 16) - 8; // -8 to 8
-        newApple.z = (rand() % 16) - 8; // -8 to 8
-
-        // Round to grid (snake moves in 1 unit increments)
-        newApple.x = floor(newApple.x) + 0.5f;
-        newApple.z = floor(newApple.z) + 0.5f;
-
-        // Check if position is valid
-        validPosition = true;
-
-        // Check collision with snake
-        for (const auto &segment : snake)
-        {
-            float dx = segment.x - newApple.x;
-            float dz = segment.z - newApple.z;
-            float distance = sqrt(dx * dx + dz * dz);
-
-            if (distance < 1.0f)
-            { // Too close to snake
-                validPosition = false;
-                break;
-            }
-        }
-
-        // Check collision with existing apples
-        for (const auto &apple : apples)
-        {
-            float dx = apple.x - newApple.x;
-            float dz = apple.z - newApple.z;
-            float distance = sqrt(dx * dx + dz * dz);
-
-            if (distance < 2.0f)
-            { // Too close to another apple
-                validPosition = false;
-                break;
-            }
-        }
-        if (!validPosition)
-            continue;
-
-        // Check collision with walls
-        for (const auto &wall : walls)
-        {
-            float wall_half_w = wall.w / 2.0f;
-            float wall_half_d = wall.d / 2.0f;
-
-            float wall_min_x = wall.x - wall_half_w;
-            float wall_max_x = wall.x + wall_half_w;
-            float wall_min_z = wall.z - wall_half_d;
-            float wall_max_z = wall.z + wall_half_d;
-
-            // AABB check for apple position against the wall
-            if (newApple.x >= wall_min_x && newApple.x <= wall_max_x &&
-                newApple.z >= wall_min_z && newApple.z <= wall_max_z)
-            {
-                validPosition = false;
-                break;
-            }
-        }
-
-        attempts++;
-    }
-
-    if (validPosition)
-    {
-        newApple.active = true;
-        apples.push_back(newApple);
-    }
-}
-
-void checkAppleCollision()
-{
-    if (snake.empty() || gameState != PLAYING)
-        return;
-
-    Segment head = snake[0];
-
-    for (auto it = apples.begin(); it != apples.end();)
-    {
-        if (!it->active)
-        {
-            it = apples.erase(it);
-            continue;
-        }
-
-        float dx = head.x - it->x;
-        float dz = head.z - it->z;
-        float distance = sqrt(dx * dx + dz * dz);
-
-        // If snake head touches apple
-        if (distance < 0.8f)
-        {
-            // Increase score and update high score
-            score++;
-            if (score > highScore)
-                highScore = score;
-
-            // Grow snake by adding segment at tail
-            Segment newSegment;
-            if (snake.size() > 1)
-            {
-                // Extend in direction opposite to movement
-                Segment tail = snake.back();
-                Segment beforeTail = snake[snake.size() - 2];
-
-                newSegment.x = tail.x + (tail.x - beforeTail.x);
-                newSegment.z = tail.z + (tail.z - beforeTail.z);
-            }
-            else
-            {
-                // Just duplicate last segment
-                newSegment = snake.back();
-            }
-            snake.push_back(newSegment);
-
-            // Remove apple
-            it = apples.erase(it);
-
-            // Spawn new apple
-            spawnApple();
-
-            break;
-        }
-        else
-        {
-            ++it;
-        }
-    }
-}
-
-void initApples()//places the apples
-{
-    apples.clear();
-    spawnApple();
-}
-
-//Wall Functions 
-void initWalls()//places the walls
-{
-    walls.clear();
-    // Boundary walls
-    walls.push_back({0, -10, 20.5, 0.5}); // South
-    walls.push_back({0, 10, 20.5, 0.5});  // North
-    walls.push_back({-10, 0, 0.5, 20.5}); // West
-    walls.push_back({10, 0, 0.5, 20.5});  // East
-
-    // Interior walls
-    walls.push_back({-4, -4, 4, 0.8});
-    walls.push_back({5, 3, 0.8, 6});
-}
-
-// Collision Detection 
-bool checkWallCollision()
-{
-    if (snake.empty())
-        return false;
-
-    Segment head = snake[0];
-
-    // Check collision with all walls
-    for (const auto &wall : walls)
-    {
-        float wall_half_w = wall.w / 2.0f;
-        float wall_half_d = wall.d / 2.0f;
-
-        float wall_min_x = wall.x - wall_half_w;
-        float wall_max_x = wall.x + wall_half_w;
-        float wall_min_z = wall.z - wall_half_d;
-        float wall_max_z = wall.z + wall_half_d;
-
-        // Simple AABB collision detection
-        if (head.x >= wall_min_x && head.x <= wall_max_x &&
-            head.z >= wall_min_z && head.z <= wall_max_z)
-        {
-            return true; // Collision
-        }
-    }
-
-    return false;
-}
-
-bool checkSelfCollision()
-{
-    if (snake.empty())
-        return false;
-
-    Segment head = snake[0];
-
-    for (size_t i = 1; i < snake.size(); i++)
-    {
-        if (head.x == snake[i].x && head.z == snake[i].z)
-        {
-            return true;
-        }
-    }
-    return false;
-}
-
 
 void drawTexturedWall(float x, float z, float w, float d, float h)//this one draws the walls
 {
@@ -701,48 +467,49 @@ void drawSnakeSegment(float x, float z, bool isHead, Direction facing)
 
 void drawScene()
 {
-    // Ground
+    // Ground, spanning the board from the first to the last wall line
+    float minX = SnakeSim::worldX(0), maxX = SnakeSim::worldX(SnakeSim::WIDTH - 1);
+    float minZ = SnakeSim::worldZ(0), maxZ = SnakeSim::worldZ(SnakeSim::HEIGHT - 1);
+    float repeatX = (maxX - minX) / 4.0f, repeatZ = (maxZ - minZ) / 4.0f;
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, groundTexture);
     glNormal3f(0, 1, 0);
     glBegin(GL_QUADS);
     glTexCoord2f(0.0f, 0.0f);
-    glVertex3f(-10.0f, 0.0f, -10.0f);
-    glTexCoord2f(5.0f, 0.0f);
-    glVertex3f(10.0f, 0.0f, -10.0f);
-    glTexCoord2f(5.0f, 5.0f);
-    glVertex3f(10.0f, 0.0f, 10.0f);
-    glTexCoord2f(0.0f, 5.0f);
-    glVertex3f(-10.0f, 0.0f, 10.0f);
+    glVertex3f(minX, 0.0f, minZ);
+    glTexCoord2f(repeatX, 0.0f);
+    glVertex3f(maxX, 0.0f, minZ);
+    glTexCoord2f(repeatX, repeatZ);
+    glVertex3f(maxX, 0.0f, maxZ);
+    glTexCoord2f(0.0f, repeatZ);
+    glVertex3f(minX, 0.0f, maxZ);
     glEnd();
     glDisable(GL_TEXTURE_2D);
 
     // Draw all walls from the vector
-    for (const auto &wall : walls)
+    for (const auto &wall : SnakeSim::walls())
     {
         drawTexturedWall(wall.x, wall.z, wall.w, wall.d, 1.5);
     }
 
-    // Draw apples
+    // Draw apples (centered on their cell, like snake segments)
     glDisable(GL_LIGHTING);
-    for (const auto &apple : apples)
+    for (const auto &apple : game.apples())
     {
-        if (apple.active)
-        {
-            drawApple(apple.x, apple.z);
-        }
+        drawApple(SnakeSim::worldX(apple.x), SnakeSim::worldZ(apple.z));
     }
 
     // Snake
+    const SnakeSim::Body &snake = game.snake();
     for (size_t i = 0; i < snake.size(); i++)
     {
         if (i == 0)
         {
-            drawSnakeSegment(snake[i].x, snake[i].z, true, currentDir);
+            drawSnakeSegment(SnakeSim::worldX(snake[i].x), SnakeSim::worldZ(snake[i].z), true, game.direction());
         }
         else
         {
-            drawSnakeSegment(snake[i].x, snake[i].z, false, currentDir);
+            drawSnakeSegment(SnakeSim::worldX(snake[i].x), SnakeSim::worldZ(snake[i].z), false, game.direction());
         }
     }
     glEnable(GL_LIGHTING);
@@ -787,7 +554,7 @@ void drawGameOverScreen()
     glColor3f(1, 1, 1); // White
     glRasterPos2f(350, 350);
     char scoreText[50];
-    sprintf(scoreText, "Score: %d", score);
+    sprintf(scoreText, "Score: %d", game.score());
     for (char *c = scoreText; *c != '\0'; c++)
     {
         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
@@ -796,7 +563,7 @@ void drawGameOverScreen()
     // High Score
     glRasterPos2f(350, 320);
     char highScoreText[50];
-    sprintf(highScoreText, "High Score: %d", highScore);
+    sprintf(highScoreText, "High Score: %d", game.highScore());
     for (char *c = highScoreText; *c != '\0'; c++)
     {
         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
@@ -839,7 +606,7 @@ void drawHUD()
     glColor3f(1, 1, 1);
     glRasterPos2f(10, 580);
     char scoreText[50];
-    sprintf(scoreText, "Score: %d", score);
+    sprintf(scoreText, "Score: %d", game.score());
     for (char *c = scoreText; *c != '\0'; c++)
     {
         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
@@ -848,7 +615,7 @@ void drawHUD()
     // High score display (top-right)
     glRasterPos2f(650, 580);
     char highScoreText[50];
-    sprintf(highScoreText, "High Score: %d", highScore);
+    sprintf(highScoreText, "High Score: %d", game.highScore());
     for (char *c = highScoreText; *c != '\0'; c++)
     {
         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
@@ -863,108 +630,81 @@ void drawHUD()
     glEnable(GL_LIGHTING);
 }
 
-// Game Logic Functions
-void moveSnake()
+//GLUT Callbacks
+void update(int value)
 {
-    if (gameState != PLAYING)
-        return;
-
-    // Calculate new head position based on direction
-    Segment newHead = snake[0];
-    switch (currentDir)
+    if (game.state() == PLAYING)
     {
-    case UP:
-        newHead.z -= 1.0f;
-        break;
-    case DOWN:
-        newHead.z += 1.0f;
-        break;
-    case LEFT:
-        newHead.x -= 1.0f;
-        break;
-    case RIGHT:
-        newHead.x += 1.0f;
-        break;
+        if (searchAutopilot)
+            nextDir = (*searchAutopilot)(game);
+        else if (autopilotOn)
+            nextDir = autopilot(game);
+        if (game.step(nextDir) == GAME_OVER)
+        {
+            printf("Game Over! Final Score: %d | High Score: %d\n", game.score(), game.highScore());
+        }
     }
-
-    // Insert new head at front
-    snake.insert(snake.begin(), newHead);
-    // Remove tail (unless we just ate an apple - handled in checkAppleCollision)
-    snake.pop_back();
-}
-
-void checkGameOver()
-{
-    if (checkWallCollision() || checkSelfCollision())
+    else if (autopilotOn)
     {
-        gameState = GAME_OVER;
-        printf("Game Over! Final Score: %d | High Score: %d\n", score, highScore);
+        game.reset(); // Attract mode starts over by itself
     }
-}
-
-void resetGame()
-{
-    // Reset snake to initial state
-    snake = {{0, 0}, {0, 1}, {0, 2}};
-    currentDir = UP;
 
-    // Clear apples and spawn new ones
-    apples.clear();
-    initApples();
-
-    // Reset score (keep high score)
-    score = 0;
-
-    // Return to playing state
-    gameState = PLAYING;
-
-    printf("Game Restarted!\n");
+    glutPostRedisplay();
+    glutTimerFunc(150, update, 0); // Update every 150ms
 }
 
-//GLUT Callbacks
-void update(int value)
+// --view mode: show whatever the publisher last wrote to our slot. A slot
+// caught mid-write, or holding a state that doesn't check out, just keeps
+// the previous frame.
+void updateView(int value)
 {
-    if (gameState == PLAYING)
+    int32_t id;
+    if (viewed.read(viewSlot, id, game) && id != viewedGame)
     {
-        moveSnake();
-        checkAppleCollision();
-        checkGameOver();
+        viewedGame = id;
+        printf("Viewing game %d (slot %d)\n", id, viewSlot);
     }
 
     glutPostRedisplay();
-    glutTimerFunc(150, update, 0); // Update every 150ms
+    glutTimerFunc(30, updateView, 0);
 }
 
 void keyboard(unsigned char key, int x, int y)
 {
-    if (key == ' ' && gameState == GAME_OVER)
+    if (viewed.valid())
+        return;
+    if (key == ' ' && game.state() == GAME_OVER)
     {
-        resetGame();
+        game.reset();
+        nextDir = UP;
+        printf("Game Restarted!\n");
     }
 }
 
 void specialKeys(int key, int x, int y)
 {
-    if (gameState != PLAYING)
+    if (viewed.valid() || game.state() != PLAYING)
         return;
 
+    // Reversal is checked against the heading the snake actually moved in
+    Direction currentDir = game.direction();
     switch (key)
     {
     case GLUT_KEY_UP:
         if (currentDir != DOWN)
-            currentDir = UP;
+            nextDir = UP;
         break;
     case GLUT_KEY_DOWN:
         if (currentDir != UP)
-            currentDir = DOWN;
+            nextDir = DOWN;
         break;
     case GLUT_KEY_LEFT:
         if (currentDir != RIGHT)
-            currentDir = LEFT;
+            nextDir = LEFT;
         break;
     case GLUT_KEY_RIGHT:
         if (currentDir != LEFT)
-            currentDir = RIGHT;
+            nextDir = RIGHT;
         break;
     }
 }
@@ -988,7 +728,7 @@ void display()
     //score display
     drawHUD();
 
-    if (gameState == GAME_OVER)
+    if (game.state() == GAME_OVER)
     {
         drawGameOverScreen();
     }
@@ -1007,10 +747,11 @@ void reshape(int w, int h)
     glMatrixMode(GL_MODELVIEW);
 }
 
-void init()
+void init(uint64_t seed)
 {
-    // Initialize random seed
-    srand(static_cast<unsigned>(time(0)));
+    // Seed the game so a run can be replayed with --seed
+    game.seed(seed);
+    printf("Seed: %llu\n", (unsigned long long)seed);
 
     // Set up OpenGL
     glClearColor(0.1, 0.1, 0.1, 1.0);
@@ -1047,8 +788,7 @@ void init()
     }
 
     // Initialize game objects
-    initWalls();
-    initApples();
+    game.reset();
 
     printf("=== 3D Snake Game ===\n");
     printf("Controls: Arrow Keys to move\n");
@@ -1060,17 +800,67 @@ void init()
 int main(int argc, char **argv)
 {
     glutInit(&argc, argv);
+
+    // glutInit() has already taken its own options out of argv
+    uint64_t seed = uint64_t(time(0));
+    const char *viewName = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--view") == 0 && i + 1 < argc)
+        {
+            viewName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--slot") == 0 && i + 1 < argc)
+        {
+            viewSlot = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--autopilot") == 0)
+        {
+            autopilotOn = true;
+            if (i + 1 < argc && strcmp(argv[i + 1], "mcts") == 0)
+            {
+                static WorkStealingPool searchPool;
+                static MctsAutopilot<ClassicRules> search(MctsConfig(), &searchPool);
+                searchAutopilot = &search;
+                i++;
+            }
+        }
+    }
+
+    // Watch a game published by a batch process (snake_env_share)
+    if (viewName)
+    {
+        if (!viewed.open(viewName))
+        {
+            printf("No shared game states named %s\n", viewName);
+            return 1;
+        }
+        if (!viewed.holds<ClassicRules>() || viewSlot < 0 || viewSlot >= viewed.slots())
+        {
+            printf("%s holds %d games of a %dx%d board; can only show classic games, slots 0-%d\n", viewName,
+                   viewed.slots(), viewed.width(), viewed.height(), viewed.slots() - 1);
+            return 1;
+        }
+    }
+
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutCreateWindow("3D Snake Game");
 
-    init();
+    init(seed);
 
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutSpecialFunc(specialKeys);
     glutKeyboardFunc(keyboard);
-    glutTimerFunc(150, update, 0);
+    if (viewed.valid())
+        glutTimerFunc(30, updateView, 0);
+    else
+        glutTimerFunc(150, update, 0);
 
     glutMainLoop();
     return 0;
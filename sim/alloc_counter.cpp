@@ -0,0 +1,85 @@
+#include "alloc_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+// Plain POD, so it needs no constructor and is safe to touch from the very
+// first allocation a thread makes
+static thread_local AllocCounts counts;
+
+AllocCounts threadAllocCounts()
+{
+    return counts;
+}
+
+static void *countedAlloc(size_t size)
+{
+    counts.allocations++;
+    counts.bytes += size;
+    return malloc(size == 0 ? 1 : size);
+}
+
+static void *countedAlignedAlloc(size_t size, size_t align)
+{
+    counts.allocations++;
+    counts.bytes += size;
+    // aligned_alloc wants the size rounded up to the alignment
+    size_t rounded = (size + align - 1) / align * align;
+    return aligned_alloc(align, rounded == 0 ? align : rounded);
+}
+
+static void countedFree(void *p)
+{
+    if (p)
+    {
+        counts.frees++;
+        free(p);
+    }
+}
+
+void *operator new(size_t size)
+{
+    void *p = countedAlloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    void *p = countedAlignedAlloc(size, size_t(align));
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size, std::align_val_t align)
+{
+    return operator new(size, align);
+}
+
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, size_t) noexcept { countedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete(void *p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { countedFree(p); }
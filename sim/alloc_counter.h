@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap traffic counters. Linking anything from this header pulls in a
+// replacement global operator new/delete that counts every allocation and
+// free made by the calling thread; the program's behaviour is otherwise
+// unchanged.
+//
+// The game itself holds no heap memory: once the first game of a rule set
+// has built the shared wall layout, step() and reset() never allocate.
+// Wrap a phase in an AllocScope to check that, e.g.
+//
+//     AllocScope scope;
+//     game.step(dir);
+//     assert(scope.delta().allocations == 0);
+
+struct AllocCounts
+{
+    uint64_t allocations; // Calls to operator new (any form)
+    uint64_t frees;       // Calls to operator delete with a non-null pointer
+    uint64_t bytes;       // Bytes requested from operator new
+};
+
+// Totals for the calling thread since it started
+AllocCounts threadAllocCounts();
+
+// Counts the allocations the calling thread makes while the scope is alive
+class AllocScope
+{
+public:
+    AllocScope() : start(threadAllocCounts()) {}
+
+    AllocCounts delta() const
+    {
+        AllocCounts now = threadAllocCounts();
+        return {now.allocations - start.allocations, now.frees - start.frees,
+                now.bytes - start.bytes};
+    }
+
+private:
+    AllocCounts start;
+};
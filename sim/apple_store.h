@@ -0,0 +1,85 @@
+#pragma once
+
+#include "occupancy_grid.h"
+#include "sim_types.h"
+
+// Up to CAPACITY apples kept inline, plus a cell -> slot table. The board
+// is bounded, so the table is a perfect spatial hash: finding the apple
+// under the head and removing it are both O(1), with no allocation and no
+// scan however many apples are out.
+template <int CAPACITY, int WIDTH, int HEIGHT>
+class AppleStore
+{
+public:
+    typedef OccupancyGrid<WIDTH, HEIGHT> Grid;
+    typedef CellIndex<CAPACITY> Slot;
+    static constexpr Slot NONE = Slot(~Slot(0));
+
+    AppleStore() : count(0)
+    {
+        for (int i = 0; i < Grid::CELLS; i++)
+            slotAt[i] = NONE;
+    }
+
+    void clear()
+    {
+        // Only occupied cells hold a slot, so clearing touches just those
+        for (int i = 0; i < count; i++)
+            slotAt[cellOf(items[i])] = NONE;
+        count = 0;
+    }
+
+    bool full() const { return count == CAPACITY; }
+
+    void add(Apple apple)
+    {
+        slotAt[cellOf(apple)] = Slot(count);
+        items[count++] = apple;
+    }
+
+    // Slot of the apple on a grid cell, -1 if there is none
+    int find(int cell) const { return slotAt[cell] == NONE ? -1 : int(slotAt[cell]); }
+
+    // Swap-remove: the last apple moves into the freed slot
+    void removeAt(int slot)
+    {
+        slotAt[cellOf(items[slot])] = NONE;
+        Apple last = items[--count];
+        if (slot != count)
+        {
+            items[slot] = last;
+            slotAt[cellOf(last)] = Slot(slot);
+        }
+    }
+
+    int size() const { return count; }
+    const Apple &operator[](int i) const { return items[i]; }
+
+    // Whether the store is one add()/removeAt() could have left: every
+    // apple on the board and in the slot its cell points at, and no other
+    // cell pointing anywhere. For stores copied in from outside.
+    bool consistent() const
+    {
+        if (count < 0 || count > CAPACITY)
+            return false;
+        for (int i = 0; i < count; i++)
+        {
+            if (unsigned(items[i].x) >= unsigned(WIDTH) || unsigned(items[i].z) >= unsigned(HEIGHT) ||
+                slotAt[cellOf(items[i])] != Slot(i))
+                return false;
+        }
+        int slots = 0;
+        for (int i = 0; i < Grid::CELLS; i++)
+            slots += slotAt[i] != NONE;
+        return slots == count;
+    }
+    const Apple *begin() const { return items; }
+    const Apple *end() const { return items + count; }
+
+private:
+    static int cellOf(const Apple &apple) { return Grid::index(apple.x, apple.z); }
+
+    Apple items[CAPACITY];
+    Slot slotAt[Grid::CELLS];
+    int count;
+};
@@ -0,0 +1,73 @@
+#include "arena.h"
+
+#include <new>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#else
+#include <cstdlib>
+#endif
+
+namespace
+{
+const size_t HUGE_PAGE = size_t(2) << 20;
+}
+
+Arena::Arena(size_t bytes) : base(nullptr), size(0), offset(0), huge(false)
+{
+    // Whole huge pages, so the kernel can back all of it with them
+    size = bytes >= HUGE_PAGE ? (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1) : (bytes + 4095) & ~size_t(4095);
+    if (size == 0)
+        size = 4096;
+#if defined(__linux__)
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        throw std::bad_alloc();
+    base = static_cast<uint8_t *>(p);
+#if defined(MADV_HUGEPAGE)
+    if (size >= HUGE_PAGE)
+        huge = madvise(base, size, MADV_HUGEPAGE) == 0;
+#endif
+#else
+    base = static_cast<uint8_t *>(std::malloc(size));
+    if (!base)
+        throw std::bad_alloc();
+#endif
+}
+
+Arena::~Arena()
+{
+#if defined(__linux__)
+    munmap(base, size);
+#else
+    std::free(base);
+#endif
+}
+
+void *Arena::allocate(size_t bytes, size_t align)
+{
+    size_t start = (offset + align - 1) & ~(align - 1);
+    if (start > size || bytes > size - start)
+        throw std::bad_alloc();
+    offset = start + bytes;
+    return base + start;
+}
+
+bool pinThisThread(unsigned cpu)
+{
+#if defined(__linux__)
+    unsigned cpus = std::thread::hardware_concurrency();
+    if (cpus == 0)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % cpus, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
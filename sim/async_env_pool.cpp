@@ -0,0 +1,6 @@
+#include "async_env_pool.h"
+
+// Rule sets compiled into the library
+template class AsyncEnvPool<ClassicRules>;
+template class AsyncEnvPool<WrapRules>;
+template class AsyncEnvPool<AppleRainRules>;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "lockfree_queue.h"
+#include "snake_sim.h"
+
+// Games stepped asynchronously on worker threads, in the style of envpool.
+// Each worker owns a contiguous block of games. The caller send()s actions
+// for any games it has results for, and recv() hands back whichever games
+// finished first, so a game that is resetting never holds up the rest and
+// the caller can run its policy on one batch while others are stepping.
+//
+// Requests go to each worker through its own SPSC ring; finished game ids
+// come back through one MPSC ring. Results land in preallocated per-game
+// arrays, written by the worker before it publishes the id. A worker with
+// nothing to do spins briefly, then parks on a condition variable that
+// send() only touches when the worker is actually parked.
+//
+// Each worker builds its games and their observation buffers itself, in
+// one Arena, so the memory is first touched (and on NUMA machines placed)
+// by the thread that steps it. The arenas are mapped up front on the
+// caller's thread, so a failed mapping throws std::bad_alloc from the
+// constructor, as does a worker that fails to build its games. With pin
+// set, worker w is pinned to CPU w.
+//
+// Game i plays the same as SnakeGame<Rules>(seed + i) given the same moves
+// and auto-resets after each GAME_OVER, like BatchEnv. Only one request per
+// game may be in flight: send a game again only after recv() returned it.
+// Since each worker's ring holds one request per game it owns, send() and
+// reset() refuse anything that would break this rather than overflow it.
+template <class Rules>
+class AsyncEnvPool
+{
+public:
+    typedef SnakeGame<Rules> Game;
+    typedef typename Game::Grid Grid;
+
+    // threads = 0 uses every hardware thread (but no more than count)
+    AsyncEnvPool(int count, uint64_t seed, unsigned threads = 0, bool pin = false);
+    ~AsyncEnvPool();
+
+    int size() const { return int(games.size()); }
+    unsigned workerCount() const { return unsigned(workers.size()); }
+
+    // Queues a new round for every game; each comes back through recv().
+    // Returns false, queuing nothing, if any game is still in flight.
+    bool reset();
+
+    // Queues one step for each of ids[0..count), actions[k] a Direction.
+    // Returns false, queuing nothing, if an id is out of range, repeated,
+    // or still in flight (sent and not yet returned by recv()).
+    bool send(const int32_t *ids, const uint8_t *actions, int count);
+
+    // Waits until batch games are done and writes their ids; returns how
+    // many it wrote. Asking for more games than are in flight waits only
+    // for those, so with nothing in flight it returns 0 at once.
+    int recv(int32_t *ids, int batch);
+
+    // Results of the last step of game id, valid once recv() returned it:
+    // reward +1 apple, -1 death; done and the final score when the round
+    // ended (the game has already been reset); the grid observation with
+    // the head marked OBS_CELL_HEAD, Grid::CELLS bytes
+    float reward(int id) const { return rewards[id]; }
+    bool done(int id) const { return dones[id] != 0; }
+    int32_t finalScore(int id) const { return finalScores[id]; }
+    const uint8_t *observation(int id) const { return observations[id]; }
+    const Game &game(int id) const { return *games[id]; }
+
+private:
+    enum
+    {
+        ACTION_RESET = 0xff
+    };
+
+    enum
+    {
+        BUILDING,
+        BUILT,
+        BUILD_FAILED
+    };
+
+    struct Request
+    {
+        int32_t id;
+        uint8_t action;
+    };
+
+    struct Worker
+    {
+        Worker(int first, int last) : begin(first), end(last), requests(size_t(last - first)), parked(false), built(BUILDING) {}
+
+        int begin, end; // Games owned
+        std::unique_ptr<Arena> arena;
+        SpscQueue<Request> requests;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::atomic<bool> parked;
+        std::atomic<int> built; // BUILDING, then BUILT or BUILD_FAILED
+        std::thread thread;
+    };
+
+    bool push(const Request &request);
+    void stopWorkers();
+    void workerLoop(unsigned w, uint64_t seed, bool pin);
+    void process(const Request &request);
+    void observe(int id);
+
+    std::vector<Game *> games; // Into the owning worker's arena
+    std::vector<uint8_t *> observations;
+    std::vector<uint32_t> owner;
+    std::vector<float> rewards;
+    std::vector<uint8_t> dones;
+    std::vector<int32_t> finalScores;
+    std::vector<uint8_t> inFlight; // Sent and not yet returned; caller side only
+    int inFlightCount;             // Entries set in inFlight
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    MpscQueue<int32_t> finished;
+    std::atomic<bool> stopping;
+};
+
+#include "async_env_pool_impl.h"
+
+extern template class AsyncEnvPool<ClassicRules>;
+extern template class AsyncEnvPool<WrapRules>;
+extern template class AsyncEnvPool<AppleRainRules>;
@@ -0,0 +1,266 @@
+#pragma once
+
+// Member definitions for AsyncEnvPool; included from async_env_pool.h only.
+
+#include <cstring>
+#include <new>
+
+#include "observation.h"
+
+template <class Rules>
+AsyncEnvPool<Rules>::AsyncEnvPool(int count, uint64_t seed, unsigned threads, bool pin)
+    : games(count), observations(count), owner(count), rewards(count), dones(count), finalScores(count),
+      inFlight(count), inFlightCount(0), finished(size_t(count)), stopping(false)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    if (threads > unsigned(count))
+        threads = unsigned(count);
+
+    // Contiguous blocks, so neighbouring result entries share an owner. The
+    // arenas are only mapped here; their pages are touched by the workers.
+    for (unsigned w = 0; w < threads; w++)
+    {
+        int begin = int(uint64_t(count) * w / threads), end = int(uint64_t(count) * (w + 1) / threads);
+        for (int i = begin; i < end; i++)
+            owner[i] = w;
+        workers.emplace_back(new Worker(begin, end));
+        size_t owned = size_t(end - begin);
+        workers[w]->arena.reset(new Arena(owned * sizeof(Game) + owned * Grid::CELLS + 128));
+    }
+    try
+    {
+        for (unsigned w = 0; w < threads; w++)
+            workers[w]->thread = std::thread(&AsyncEnvPool::workerLoop, this, w, seed, pin);
+    }
+    catch (...)
+    {
+        stopWorkers(); // Whichever did start
+        throw;
+    }
+
+    // Workers build their own games; wait until every game exists
+    bool failed = false;
+    for (auto &worker : workers)
+    {
+        int built;
+        while ((built = worker->built.load(std::memory_order_acquire)) == BUILDING)
+            std::this_thread::yield();
+        failed |= built == BUILD_FAILED;
+    }
+    if (failed)
+    {
+        stopWorkers();
+        throw std::bad_alloc();
+    }
+}
+
+template <class Rules>
+AsyncEnvPool<Rules>::~AsyncEnvPool()
+{
+    stopWorkers();
+}
+
+template <class Rules>
+void AsyncEnvPool<Rules>::stopWorkers()
+{
+    stopping.store(true);
+    for (auto &worker : workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+        }
+        worker->wake.notify_one();
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+template <class Rules>
+bool AsyncEnvPool<Rules>::reset()
+{
+    for (int i = 0; i < size(); i++)
+    {
+        if (inFlight[i])
+            return false;
+    }
+    bool queued = true;
+    for (int i = 0; i < size(); i++)
+    {
+        inFlight[i] = 1;
+        inFlightCount++;
+        if (!push({i, ACTION_RESET}))
+        {
+            inFlight[i] = 0;
+            inFlightCount--;
+            queued = false;
+        }
+    }
+    return queued;
+}
+
+template <class Rules>
+bool AsyncEnvPool<Rules>::send(const int32_t *ids, const uint8_t *actions, int count)
+{
+    for (int k = 0; k < count; k++)
+    {
+        int32_t id = ids[k];
+        if (id < 0 || id >= size() || inFlight[id])
+        {
+            for (int j = 0; j < k; j++)
+                inFlight[ids[j]] = 0;
+            return false;
+        }
+        inFlight[id] = 1;
+    }
+    inFlightCount += count;
+    bool queued = true;
+    for (int k = 0; k < count; k++)
+    {
+        if (!push({ids[k], actions[k]}))
+        {
+            inFlight[ids[k]] = 0;
+            inFlightCount--;
+            queued = false;
+        }
+    }
+    return queued;
+}
+
+template <class Rules>
+bool AsyncEnvPool<Rules>::push(const Request &request)
+{
+    Worker &worker = *workers[owner[request.id]];
+    // The ring holds every game the worker owns, and send() and reset()
+    // keep each game to one request in flight, so this never fails; if it
+    // somehow does, the game is simply not queued and the caller says so
+    if (!worker.requests.push(request))
+        return false;
+
+    // Pairs with the fence in workerLoop(): either the worker sees the
+    // request before parking, or we see it parked and wake it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.parked.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.wake.notify_one();
+    }
+    return true;
+}
+
+template <class Rules>
+int AsyncEnvPool<Rules>::recv(int32_t *ids, int batch)
+{
+    // Every game in flight comes back, so this many never waits forever
+    if (batch > inFlightCount)
+        batch = inFlightCount;
+    int got = 0;
+    while (got < batch)
+    {
+        if (finished.pop(ids[got]))
+            inFlight[ids[got++]] = 0;
+        else
+            std::this_thread::yield();
+    }
+    inFlightCount -= got;
+    return got;
+}
+
+template <class Rules>
+void AsyncEnvPool<Rules>::workerLoop(unsigned w, uint64_t seed, bool pin)
+{
+    const int SPINS = 64;
+    Worker &worker = *workers[w];
+
+    // Pin first, so the first touch below happens on this worker's CPU
+    if (pin)
+        pinThisThread(w);
+    // Nothing may escape the thread; the constructor rethrows for us
+    try
+    {
+        size_t owned = size_t(worker.end - worker.begin);
+        Game *block = worker.arena->template allocate<Game>(owned);
+        uint8_t *cells = worker.arena->template allocate<uint8_t>(owned * Grid::CELLS);
+        for (int i = worker.begin; i < worker.end; i++)
+        {
+            size_t k = size_t(i - worker.begin);
+            games[i] = new (block + k) Game(seed + uint64_t(i));
+            observations[i] = cells + k * Grid::CELLS;
+            observe(i);
+        }
+    }
+    catch (...)
+    {
+        worker.built.store(BUILD_FAILED, std::memory_order_release);
+        return;
+    }
+    worker.built.store(BUILT, std::memory_order_release);
+
+    Request request;
+    int idle = 0;
+    while (!stopping.load(std::memory_order_relaxed))
+    {
+        if (worker.requests.pop(request))
+        {
+            process(request);
+            idle = 0;
+            continue;
+        }
+        if (++idle < SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (worker.requests.empty() && !stopping.load())
+            worker.wake.wait(lock);
+        worker.parked.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+template <class Rules>
+void AsyncEnvPool<Rules>::process(const Request &request)
+{
+    int id = request.id;
+    Game &game = *games[id];
+    if (request.action == ACTION_RESET)
+    {
+        game.reset();
+        rewards[id] = 0.0f;
+        dones[id] = 0;
+    }
+    else
+    {
+        int before = game.score();
+        game.step(Direction(request.action));
+        rewards[id] = game.score() != before ? 1.0f : 0.0f;
+        dones[id] = game.state() == GAME_OVER;
+        if (dones[id])
+        {
+            rewards[id] = -1.0f;
+            finalScores[id] = game.score();
+            game.reset();
+        }
+    }
+    observe(id);
+
+    // Room for every game, so this can't fail either; the id is published
+    // after the results above
+    finished.push(id);
+}
+
+template <class Rules>
+void AsyncEnvPool<Rules>::observe(int id)
+{
+    const Game &game = *games[id];
+    uint8_t *out = observations[id];
+    std::memcpy(out, game.cells().data(), Grid::CELLS);
+    const Segment &head = game.snake().head();
+    out[Grid::index(head.x, head.z)] = OBS_CELL_HEAD;
+}
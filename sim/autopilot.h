@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+
+#include "bitboard.h"
+#include "flood_fill.h"
+#include "snake_sim.h"
+
+// Steers along a shortest path to the nearest apple. The search runs
+// backwards, breadth first from every apple at once, one whole layer per
+// step as bit operations on the passable cells; the first of the head's
+// candidate cells that a layer reaches is the first step of a shortest
+// path. All scratch is inline fixed-size bitboards, so a decision makes no
+// allocations.
+//
+// Paths only run through free cells, but the first step may also be into
+// the tail when it is about to move off (safeMoves()): candidates are
+// tested against each layer before it is cut down to free cells. When no
+// apple can be reached it heads for the most room (ReachableArea): a
+// region the tail borders, else the biggest, straight on when it's a tie.
+// With no safe move at all it keeps going straight.
+//
+// Usable as a policy for runEpisodes() and snake_eval, or called once per
+// tick to fill in nextDir.
+template <class Rules>
+class BfsAutopilot
+{
+public:
+    typedef SnakeGame<Rules> Game;
+    typedef BoardBits<Game::WIDTH, Game::HEIGHT, Rules::WRAP> Board;
+    typedef typename Board::Bits Bits;
+
+    void reset(uint64_t) { area = ReachableArea<Rules>(); }
+
+    Direction operator()(const Game &game)
+    {
+        static const int DX[4] = {0, 0, -1, 1};
+        static const int DZ[4] = {-1, 1, 0, 0};
+
+        packCells(game.cells().data(), Game::CELLS, passable.words, frontier.words);
+
+        // The three ways the head can go, minus any that hit something now
+        const Segment &head = game.snake().head();
+        Direction current = game.direction();
+        unsigned safe = game.safeMoves();
+        int target[4];
+        int candidates = 0;
+        for (int d = 0; d < 4; d++)
+        {
+            target[d] = -1;
+            if (!((safe >> d) & 1))
+                continue;
+            int x = head.x + DX[d], z = head.z + DZ[d];
+            if (Rules::WRAP)
+            {
+                x = (x + Game::WIDTH) % Game::WIDTH;
+                z = (z + Game::HEIGHT) % Game::HEIGHT;
+            }
+            int cell = Game::Grid::index(x, z);
+            if (frontier.test(cell))
+                return Direction(d); // Apple right there
+            target[d] = cell;
+            candidates++;
+        }
+        if (candidates == 0)
+            return current;
+
+        // Layers out from the apples until one touches a candidate cell.
+        // The test is on next, before masking, so a candidate that isn't
+        // free (the tail) counts too.
+        visited = frontier;
+        for (;;)
+        {
+            Board::neighbours(frontier, next);
+            for (int d = 0; d < 4; d++)
+            {
+                if (target[d] >= 0 && next.test(target[d]))
+                    return Direction(d);
+            }
+            bool grew = false;
+            for (int k = 0; k < Bits::WORDS; k++)
+            {
+                uint64_t w = next.words[k] & passable.words[k] & ~visited.words[k];
+                frontier.words[k] = w;
+                visited.words[k] |= w;
+                grew |= w != 0;
+            }
+            if (!grew)
+                break;
+        }
+
+        // No apple reachable: go where there is most room, straight on if
+        // that's as good as anything. Room only needs counting up to the
+        // body length; past that there is space to wait for the tail.
+        area.update(game);
+        const int enough = int(game.snake().size());
+        int best = -1, bestRoom = -1;
+        for (int d = 0; d < 4; d++)
+        {
+            if (target[d] < 0)
+                continue;
+            Reach reach = area.from(target[d], enough);
+            int room = reach.tailReachable ? enough : reach.size;
+            if (room > bestRoom || (room == bestRoom && d == current))
+            {
+                best = d;
+                bestRoom = room;
+            }
+        }
+        return Direction(best);
+    }
+
+private:
+    Bits passable; // Empty or apple
+    Bits frontier; // Current layer (starts as the apples)
+    Bits next;
+    Bits visited;
+    ReachableArea<Rules> area; // Free cells, for the no-apple fallback
+};
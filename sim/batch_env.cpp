@@ -0,0 +1,6 @@
+#include "batch_env.h"
+
+// Rule sets compiled into the library
+template class BatchEnv<ClassicRules>;
+template class BatchEnv<WrapRules>;
+template class BatchEnv<AppleRainRules>;
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "snake_sim.h"
+
+// N independent games of one rule set, stepped together. State is kept as
+// structure-of-arrays: heads, headings, body rings, apples, grids, scores
+// and done flags each live in their own array, so the per-game loops that
+// only touch heads and headings are straight-line code the compiler can
+// vectorize, and the rest walks each array in order.
+//
+// Every game follows exactly the rules of SnakeGame<Rules>: game i plays
+// the same as SnakeGame<Rules>(seed + i) given the same moves, reset
+// after each GAME_OVER. Finished games are reset automatically inside
+// step(); dones() and finalScores() report what just ended.
+template <class Rules>
+class BatchEnv
+{
+public:
+    typedef SnakeGame<Rules> Game;
+    typedef typename Game::Grid Grid;
+    typedef typename Game::Body Body;
+    typedef typename Game::Apples Apples;
+    typedef typename Game::FreeCells FreeCells;
+
+    BatchEnv(int count, uint64_t seed);
+
+    int size() const { return n; }
+
+    // Points the per-step outputs at caller-owned arrays of size() entries,
+    // so step() writes them in place with no copy afterwards. Passing null
+    // for any of them goes back to the env's own array.
+    void bindOutputs(float *rewards, uint8_t *dones, int32_t *finalScores);
+
+    // Starts a new round in every game
+    void reset();
+
+    // Advances every game by one tick; actions[i] is a Direction for game i.
+    // Fills rewards() (+1 apple, -1 death, 0 otherwise) and dones().
+    void step(const uint8_t *actions);
+
+    const float *rewards() const { return rewardOut; }
+    const uint8_t *dones() const { return doneOut; }
+    const int32_t *scores() const { return score.data(); }
+    const int32_t *finalScores() const { return finalScoreOut; } // Valid where dones() is set
+
+    const int16_t *headXs() const { return headX.data(); }
+    const int16_t *headZs() const { return headZ.data(); }
+    const uint8_t *directions() const { return dir.data(); }
+
+    const Body &body(int i) const { return bodies[i]; }
+    const Apples &apples(int i) const { return appleLists[i]; }
+    const Grid &grid(int i) const { return grids[i]; }
+
+    // Game i's change log, episode and tick, kept as SnakeGame keeps them,
+    // so observers can update incrementally (see PlaneEncoder)
+    const typename Game::ChangeLog &changes(int i) const { return logs[i]; }
+    uint32_t episode(int i) const { return episodes[i]; }
+    uint32_t tick(int i) const { return ticks[i]; }
+
+    // Game i as a standalone SnakeGame. It plays on from here like game i
+    // would (the change log says overflow).
+    void copyGame(int i, Game &game) const;
+
+    // Game i's Game::Parts, written to out (sizeof(Parts) bytes, any
+    // alignment) with one memcpy per part: how games are published
+    void saveParts(int i, uint8_t *out) const;
+
+private:
+    void resetGame(int i);
+    void setCell(int i, int x, int z, CellType type);
+    void spawnApple(int i);
+
+    int n;
+
+    // Hot per-game scalars, touched by the vectorized passes
+    std::vector<int16_t> headX, headZ;
+    std::vector<int16_t> nextX, nextZ; // Scratch: where each head moves this tick
+    std::vector<uint8_t> dir;
+    std::vector<int32_t> pending;
+    std::vector<int32_t> score;
+    std::vector<int32_t> finalScore;
+    std::vector<int32_t> best; // High score over finished rounds
+    std::vector<float> reward;
+    std::vector<uint8_t> done;
+    float *rewardOut; // reward, or the caller's array from bindOutputs()
+    uint8_t *doneOut;
+    int32_t *finalScoreOut;
+
+    // Per-game tables
+    std::vector<Body> bodies;
+    std::vector<Apples> appleLists;
+    std::vector<Grid> grids;
+    std::vector<FreeCells> freeCells;
+    std::vector<Rng> rngs;
+    std::vector<typename Game::ChangeLog> logs;
+    std::vector<uint32_t> episodes;
+    std::vector<uint32_t> ticks;
+};
+
+#include "batch_env_impl.h"
+
+extern template class BatchEnv<ClassicRules>;
+extern template class BatchEnv<WrapRules>;
+extern template class BatchEnv<AppleRainRules>;
@@ -0,0 +1,233 @@
+#pragma once
+
+// Member definitions for BatchEnv; included from batch_env.h only.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+template <class Rules>
+BatchEnv<Rules>::BatchEnv(int count, uint64_t seed)
+    : n(count), headX(count), headZ(count), nextX(count), nextZ(count), dir(count),
+      pending(count), score(count), finalScore(count), best(count), reward(count), done(count),
+      rewardOut(nullptr), doneOut(nullptr), finalScoreOut(nullptr),
+      bodies(count), appleLists(count), grids(count), freeCells(count),
+      logs(count), episodes(count), ticks(count)
+{
+    bindOutputs(nullptr, nullptr, nullptr);
+    rngs.reserve(count);
+    for (int i = 0; i < count; i++)
+        rngs.push_back(Rng(seed + uint64_t(i)));
+    reset();
+}
+
+template <class Rules>
+void BatchEnv<Rules>::bindOutputs(float *rewards, uint8_t *dones, int32_t *finalScores)
+{
+    rewardOut = rewards ? rewards : reward.data();
+    doneOut = dones ? dones : done.data();
+    finalScoreOut = finalScores ? finalScores : finalScore.data();
+}
+
+template <class Rules>
+void BatchEnv<Rules>::reset()
+{
+    for (int i = 0; i < n; i++)
+    {
+        resetGame(i);
+        rewardOut[i] = 0.0f;
+        doneOut[i] = 0;
+        finalScoreOut[i] = 0;
+    }
+}
+
+// Mirrors SnakeGame::reset(), one game at a time
+template <class Rules>
+void BatchEnv<Rules>::resetGame(int i)
+{
+    const int ox = Game::ORIGIN_X, oz = Game::ORIGIN_Z;
+    Body &b = bodies[i];
+    b.clear();
+    b.pushHead({int16_t(ox), int16_t(oz + 2)});
+    b.pushHead({int16_t(ox), int16_t(oz + 1)});
+    b.pushHead({int16_t(ox), int16_t(oz)});
+    headX[i] = int16_t(ox);
+    headZ[i] = int16_t(oz);
+    pending[i] = 0;
+    dir[i] = UP;
+
+    grids[i] = Game::layout().grid;
+    freeCells[i] = Game::layout().freeCells;
+    for (size_t k = 0; k < b.size(); k++)
+        setCell(i, b[k].x, b[k].z, CELL_BODY);
+
+    appleLists[i].clear();
+    for (int k = 0; k < Rules::APPLES; k++)
+        spawnApple(i);
+
+    score[i] = 0;
+    logs[i].count = 0;
+    logs[i].overflow = true;
+    episodes[i]++;
+    ticks[i] = 0;
+}
+
+template <class Rules>
+void BatchEnv<Rules>::copyGame(int i, Game &game) const
+{
+    game.gameState = PLAYING;
+    game.currentDir = Direction(dir[i]);
+    game.body = bodies[i];
+    game.pendingGrowth = pending[i];
+    game.appleList = appleLists[i];
+    game.grid = grids[i];
+    game.freeCells = freeCells[i];
+    game.episodeCount = episodes[i];
+    game.tickCount = ticks[i];
+    game.currentScore = score[i];
+    game.bestScore = std::max(best[i], score[i]);
+    game.rng = rngs[i];
+    game.rebuild();
+}
+
+// One memcpy per part straight into place; the reader does the rebuilding
+template <class Rules>
+void BatchEnv<Rules>::saveParts(int i, uint8_t *out) const
+{
+    typedef typename Game::Parts Parts;
+    static_assert(std::is_standard_layout<Parts>::value, "parts are placed by offsetof");
+    memcpy(out + offsetof(Parts, body), &bodies[i], sizeof(Body));
+    memcpy(out + offsetof(Parts, apples), &appleLists[i], sizeof(Apples));
+    memcpy(out + offsetof(Parts, grid), &grids[i], sizeof(Grid));
+    memcpy(out + offsetof(Parts, freeCells), &freeCells[i], sizeof(FreeCells));
+    memcpy(out + offsetof(Parts, rng), &rngs[i], sizeof(Rng));
+    memcpy(out + offsetof(Parts, score), &score[i], sizeof(int32_t));
+    int32_t highScore = std::max(best[i], score[i]);
+    memcpy(out + offsetof(Parts, bestScore), &highScore, sizeof(int32_t));
+    memcpy(out + offsetof(Parts, pendingGrowth), &pending[i], sizeof(int32_t));
+    memcpy(out + offsetof(Parts, episode), &episodes[i], sizeof(uint32_t));
+    memcpy(out + offsetof(Parts, tick), &ticks[i], sizeof(uint32_t));
+    memcpy(out + offsetof(Parts, direction), &dir[i], sizeof(uint8_t));
+    out[offsetof(Parts, state)] = PLAYING; // Finished games were reset in step()
+}
+
+template <class Rules>
+void BatchEnv<Rules>::setCell(int i, int x, int z, CellType type)
+{
+    grids[i].set(x, z, type);
+    int cell = Grid::index(x, z);
+    typename Game::ChangeLog &log = logs[i];
+    if (log.count < 4)
+        log.cells[log.count++] = CellIndex<Game::CELLS>(cell);
+    else
+        log.overflow = true;
+    if (!Game::inSpawnArea(x, z))
+        return;
+    if (type == CELL_EMPTY)
+        freeCells[i].insert(cell);
+    else
+        freeCells[i].erase(cell);
+}
+
+template <class Rules>
+void BatchEnv<Rules>::spawnApple(int i)
+{
+    FreeCells &free = freeCells[i];
+    if (appleLists[i].full() || free.empty())
+        return;
+
+    int cell = free[rngs[i].below(uint32_t(free.size()))];
+    int cx = Grid::cellX(cell);
+    int cz = Grid::cellZ(cell);
+    setCell(i, cx, cz, CELL_APPLE);
+    appleLists[i].add({int16_t(cx), int16_t(cz)});
+}
+
+template <class Rules>
+void BatchEnv<Rules>::step(const uint8_t *actions)
+{
+    // Unit steps per Direction (UP, DOWN, LEFT, RIGHT); opposite is d ^ 1
+    static const int8_t DX[4] = {0, 0, -1, 1};
+    static const int8_t DZ[4] = {-1, 1, 0, 0};
+
+    // Pass 1 (vectorizable): turn, ignoring reversals, and find new heads
+    uint8_t *d = dir.data();
+    const int16_t *hx = headX.data();
+    const int16_t *hz = headZ.data();
+    int16_t *nx = nextX.data();
+    int16_t *nz = nextZ.data();
+    for (int i = 0; i < n; i++)
+    {
+        uint8_t a = actions[i] & 3;
+        uint8_t cur = d[i];
+        cur = (a == (cur ^ 1)) ? cur : a;
+        d[i] = cur;
+        nx[i] = int16_t(Game::wrap(hx[i] + DX[cur], Game::WIDTH));
+        nz[i] = int16_t(Game::wrap(hz[i] + DZ[cur], Game::HEIGHT));
+    }
+
+    // Pass 2: move bodies and resolve what each head ran into, in the same
+    // order as SnakeGame::moveSnake() / checkAppleCollision()
+    for (int i = 0; i < n; i++)
+    {
+        Body &b = bodies[i];
+        logs[i].count = 0;
+        logs[i].overflow = false;
+        ticks[i]++;
+        if (pending[i] > 0)
+        {
+            pending[i]--;
+        }
+        else
+        {
+            const Segment &tail = b.tail();
+            setCell(i, tail.x, tail.z, CELL_EMPTY);
+            b.popTail();
+        }
+
+        int x = nx[i], z = nz[i];
+        CellType hit = grids[i].at(x, z);
+        b.pushHead({int16_t(x), int16_t(z)});
+        headX[i] = int16_t(x);
+        headZ[i] = int16_t(z);
+
+        float r = 0.0f;
+        uint8_t over = 0;
+        if (hit == CELL_APPLE)
+        {
+            setCell(i, x, z, CELL_BODY);
+            int slot = appleLists[i].find(Grid::index(x, z));
+            if (slot >= 0)
+            {
+                score[i]++;
+                pending[i] += Rules::GROWTH;
+                appleLists[i].removeAt(slot);
+                spawnApple(i);
+                r = 1.0f;
+            }
+        }
+        else if (hit == CELL_EMPTY)
+        {
+            setCell(i, x, z, CELL_BODY);
+        }
+        else
+        {
+            over = 1;
+            r = -1.0f;
+        }
+        rewardOut[i] = r;
+        doneOut[i] = over;
+    }
+
+    // Pass 3: auto-reset finished games, keeping their final score
+    for (int i = 0; i < n; i++)
+    {
+        if (doneOut[i])
+        {
+            finalScoreOut[i] = score[i];
+            best[i] = std::max(best[i], score[i]);
+            resetGame(i);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#include "bitboard.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "occupancy_grid.h"
+
+void packCells(const uint8_t *grid, int cells, uint64_t *passable, uint64_t *apples)
+{
+    int words = (cells + 63) / 64;
+    if (passable)
+        memset(passable, 0, size_t(words) * 8);
+    if (apples)
+        memset(apples, 0, size_t(words) * 8);
+
+    int i = 0;
+#if defined(__SSE2__)
+    // 16 cells per compare; movemask turns each into 16 bits of a word
+    const __m128i emptyType = _mm_set1_epi8(CELL_EMPTY);
+    const __m128i appleType = _mm_set1_epi8(CELL_APPLE);
+    for (; i + 16 <= cells; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(grid + i));
+        __m128i apple = _mm_cmpeq_epi8(v, appleType);
+        uint64_t a = uint64_t(uint16_t(_mm_movemask_epi8(apple)));
+        uint64_t p = uint64_t(uint16_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, emptyType), apple))));
+        if (passable)
+            passable[i >> 6] |= p << (i & 63);
+        if (apples)
+            apples[i >> 6] |= a << (i & 63);
+    }
+#endif
+    for (; i < cells; i++)
+    {
+        uint64_t bit = uint64_t(1) << (i & 63);
+        if (passable && (grid[i] == CELL_EMPTY || grid[i] == CELL_APPLE))
+            passable[i >> 6] |= bit;
+        if (apples && grid[i] == CELL_APPLE)
+            apples[i >> 6] |= bit;
+    }
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Board-sized bit sets for bit-parallel searches: bit i is the cell with
+// grid index i (z * W + x), packed 64 cells to a word. A whole BFS layer or
+// flood-fill step is a handful of shifts, ANDs and ORs per word instead of
+// a queue walk over cells.
+template <int BITS>
+struct Bitboard
+{
+    static constexpr int WORDS = (BITS + 63) / 64;
+
+    uint64_t words[WORDS];
+
+    void clear() { memset(words, 0, sizeof(words)); }
+    void set(int i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(int i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    bool test(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+
+    bool any() const
+    {
+        uint64_t acc = 0;
+        for (int k = 0; k < WORDS; k++)
+            acc |= words[k];
+        return acc != 0;
+    }
+
+    int count() const
+    {
+        int n = 0;
+        for (int k = 0; k < WORDS; k++)
+            n += __builtin_popcountll(words[k]);
+        return n;
+    }
+
+    // Lowest set bit, or -1
+    int first() const
+    {
+        for (int k = 0; k < WORDS; k++)
+        {
+            if (words[k])
+                return k * 64 + __builtin_ctzll(words[k]);
+        }
+        return -1;
+    }
+
+    // out = in moved k bits towards higher / lower indices, zero filled
+    static void shiftUp(const Bitboard &in, int k, Bitboard &out)
+    {
+        for (int i = WORDS - 1; i >= 0; i--)
+            out.words[i] = wordShiftedUp(in, i, k >> 6, k & 63);
+    }
+
+    static void shiftDown(const Bitboard &in, int k, Bitboard &out)
+    {
+        for (int i = 0; i < WORDS; i++)
+            out.words[i] = wordShiftedDown(in, i, k >> 6, k & 63);
+    }
+
+    // Word i of in moved up / down by q words and r bits
+    static uint64_t wordShiftedUp(const Bitboard &in, int i, int q, int r)
+    {
+        uint64_t hi = i - q >= 0 ? in.words[i - q] : 0;
+        uint64_t lo = i - q - 1 >= 0 ? in.words[i - q - 1] : 0;
+        return r ? (hi << r) | (lo >> (64 - r)) : hi;
+    }
+
+    static uint64_t wordShiftedDown(const Bitboard &in, int i, int q, int r)
+    {
+        uint64_t lo = i + q < WORDS ? in.words[i + q] : 0;
+        uint64_t hi = i + q + 1 < WORDS ? in.words[i + q + 1] : 0;
+        return r ? (lo >> r) | (hi << (64 - r)) : lo;
+    }
+};
+
+// The four-neighbourhood on a W x H board as bit operations. On walled
+// boards the edge cells are walls, which searches never enter, so a plain
+// shift by 1 can't carry a cell across to the next row and needs no column
+// masks. Wrapping boards fold the edges back with masks instead.
+template <int W, int H, bool WRAP>
+struct BoardBits
+{
+    static constexpr int CELLS = W * H;
+    typedef Bitboard<CELLS> Bits;
+
+    // out = every cell next to a cell of in (in itself not included unless
+    // it neighbours another cell of in). in must have no bits past CELLS.
+    static void neighbours(const Bits &in, Bits &out)
+    {
+        if (!WRAP)
+        {
+            // One pass: each output word gathers its four shifted sources
+            const int q = W >> 6, r = W & 63;
+            for (int i = 0; i < Bits::WORDS; i++)
+            {
+                uint64_t w = in.words[i];
+                uint64_t prev = i > 0 ? in.words[i - 1] : 0;
+                uint64_t nextWord = i + 1 < Bits::WORDS ? in.words[i + 1] : 0;
+                uint64_t n = (w << 1) | (prev >> 63) | (w >> 1) | (nextWord << 63);
+                n |= Bits::wordShiftedUp(in, i, q, r) | Bits::wordShiftedDown(in, i, q, r);
+                out.words[i] = n;
+            }
+            return;
+        }
+
+        Bits t;
+        const Bits &first = masks().first, &last = masks().last;
+        Bits a, b;
+        // +x: everything but the last column moves up one; it wraps to x = 0
+        andNot(in, last, a);
+        Bits::shiftUp(a, 1, out);
+        andInto(in, last, a);
+        Bits::shiftDown(a, W - 1, t);
+        orInto(out, t);
+        // -x
+        andNot(in, first, a);
+        Bits::shiftDown(a, 1, t);
+        orInto(out, t);
+        andInto(in, first, a);
+        Bits::shiftUp(a, W - 1, t);
+        orInto(out, t);
+        // +z and -z, rotating the CELLS-bit string by a row
+        Bits::shiftUp(in, W, a);
+        Bits::shiftDown(in, CELLS - W, b);
+        orInto(out, a);
+        orInto(out, b);
+        Bits::shiftDown(in, W, a);
+        Bits::shiftUp(in, CELLS - W, b);
+        orInto(out, a);
+        orInto(out, b);
+        andInto(out, masks().all, out);
+    }
+
+    static void orInto(Bits &dst, const Bits &src)
+    {
+        for (int k = 0; k < Bits::WORDS; k++)
+            dst.words[k] |= src.words[k];
+    }
+
+    static void andInto(const Bits &a, const Bits &b, Bits &out)
+    {
+        for (int k = 0; k < Bits::WORDS; k++)
+            out.words[k] = a.words[k] & b.words[k];
+    }
+
+    static void andNot(const Bits &a, const Bits &b, Bits &out)
+    {
+        for (int k = 0; k < Bits::WORDS; k++)
+            out.words[k] = a.words[k] & ~b.words[k];
+    }
+
+    // First and last column, and every cell of the board
+    struct Masks
+    {
+        Masks()
+        {
+            first.clear();
+            last.clear();
+            all.clear();
+            for (int i = 0; i < CELLS; i++)
+            {
+                all.set(i);
+                if (i % W == 0)
+                    first.set(i);
+                if (i % W == W - 1)
+                    last.set(i);
+            }
+        }
+        Bits first, last, all;
+    };
+
+    static const Masks &masks()
+    {
+        static const Masks m;
+        return m;
+    }
+};
+
+// Packs one grid of CellType bytes into bit sets: passable gets the empty
+// and apple cells, apples the apple cells. Either may be null.
+void packCells(const uint8_t *grid, int cells, uint64_t *passable, uint64_t *apples);
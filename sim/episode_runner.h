@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "rng.h"
+#include "snake_sim.h"
+#include "work_stealing_pool.h"
+
+// Outcome of one episode
+struct EpisodeResult
+{
+    uint64_t seed;
+    int32_t score;
+    int32_t length; // Snake length when the episode ended
+    int32_t ticks;  // Ticks played
+    uint8_t died;   // 0 if the episode hit the tick limit instead
+    uint8_t cause;  // DeathCause; DEATH_NONE at the tick limit
+};
+
+// A policy is any copyable type with
+//
+//     void reset(uint64_t seed);                    // start of an episode
+//     Direction operator()(const SnakeGame<R> &);   // one decision per tick
+//
+// Each worker gets its own copy, and reset() is handed the episode seed, so
+// results depend only on the seed and never on which thread ran it.
+
+// Plays uniformly random moves
+struct RandomPolicy
+{
+    Rng rng;
+
+    void reset(uint64_t seed) { rng.reseed(seed ^ 0x5851f42d4c957f2dull); }
+
+    template <class Game>
+    Direction operator()(const Game &) { return Direction(rng.below(4)); }
+};
+
+// Heads for the nearest apple by Manhattan distance, taking any move that
+// survives the next tick (safeMoves()); if every move is fatal it keeps
+// going straight
+struct GreedyPolicy
+{
+    void reset(uint64_t) {}
+
+    template <class Rules>
+    Direction operator()(const SnakeGame<Rules> &game)
+    {
+        typedef SnakeGame<Rules> Game;
+        static const int DX[4] = {0, 0, -1, 1};
+        static const int DZ[4] = {-1, 1, 0, 0};
+        const Segment &head = game.snake().head();
+        Direction best = game.direction();
+        int bestDistance = -1;
+        unsigned safe = game.safeMoves();
+        for (int d = 0; d < 4; d++)
+        {
+            if (!((safe >> d) & 1))
+                continue;
+            int x = head.x + DX[d], z = head.z + DZ[d];
+            if (Rules::WRAP)
+            {
+                x = (x + Game::WIDTH) % Game::WIDTH;
+                z = (z + Game::HEIGHT) % Game::HEIGHT;
+            }
+            int distance = INT32_MAX;
+            for (const Apple &apple : game.apples())
+            {
+                int dx = std::abs(apple.x - x), dz = std::abs(apple.z - z);
+                if (Rules::WRAP)
+                {
+                    dx = std::min(dx, Game::WIDTH - dx);
+                    dz = std::min(dz, Game::HEIGHT - dz);
+                }
+                distance = std::min(distance, dx + dz);
+            }
+            if (bestDistance < 0 || distance < bestDistance)
+            {
+                best = Direction(d);
+                bestDistance = distance;
+            }
+        }
+        return best;
+    }
+};
+
+// Plays episodes for seeds firstSeed .. firstSeed + count - 1 across the
+// pool and hands each result to sink(result, worker) on the thread that
+// played it, so callers can fold results into per-worker accumulators
+// without storing them. Each worker reuses one game and one policy copy,
+// so the run takes no locks and allocates nothing per episode.
+template <class Rules, class Policy, class Sink>
+void runEpisodes(WorkStealingPool &pool, const Policy &policy, uint64_t firstSeed, uint64_t count,
+                 int maxTicks, Sink &sink)
+{
+    std::vector<SnakeGame<Rules>> games(pool.size());
+    std::vector<Policy> policies(pool.size(), policy);
+
+    auto play = [&](uint64_t index, unsigned worker)
+    {
+        SnakeGame<Rules> &game = games[worker];
+        Policy &p = policies[worker];
+        uint64_t seed = firstSeed + index;
+
+        game.seed(seed);
+        game.reset();
+        p.reset(seed);
+
+        int ticks = 0;
+        while (ticks < maxTicks && game.state() == PLAYING)
+        {
+            game.step(p(game));
+            ticks++;
+        }
+
+        EpisodeResult r;
+        r.seed = seed;
+        r.score = game.score();
+        r.length = int32_t(game.snake().size());
+        r.ticks = ticks;
+        r.died = game.state() == GAME_OVER;
+        r.cause = uint8_t(game.deathCause());
+        sink(r, worker);
+    };
+    pool.run(count, play);
+}
+
+// As above, writing the result of episode i to results[i]. Each worker
+// writes only its own episodes' slots.
+template <class Rules, class Policy>
+void runEpisodes(WorkStealingPool &pool, const Policy &policy, uint64_t firstSeed, uint64_t count,
+                 int maxTicks, EpisodeResult *results)
+{
+    auto store = [&](const EpisodeResult &r, unsigned) { results[r.seed - firstSeed] = r; };
+    runEpisodes<Rules>(pool, policy, firstSeed, count, maxTicks, store);
+}
@@ -0,0 +1,203 @@
+#include "flood_fill.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define FLOOD_FILL_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+// Spreads g along runs of set bits of p within the word, both ways
+inline uint64_t spreadInWord(uint64_t g, uint64_t p)
+{
+    uint64_t up = g, pu = p;
+    uint64_t down = g, pd = p;
+    for (int s = 1; s < 64; s <<= 1)
+    {
+        up |= pu & (up << s);
+        pu &= pu << s;
+        down |= pd & (down >> s);
+        pd &= pd >> s;
+    }
+    return up | down;
+}
+
+struct SweepState
+{
+    int added;
+    int lo, hi;
+};
+
+inline void sweepWord(uint64_t *region, const uint64_t *passable, int words, int q, int r, int i, SweepState &s)
+{
+    uint64_t w = region[i];
+    uint64_t prev = i > 0 ? region[i - 1] : 0;
+    uint64_t next = i + 1 < words ? region[i + 1] : 0;
+    uint64_t g = w | (w << 1) | (w >> 1) | (prev >> 63) | (next << 63);
+
+    // A row above and a row below: q words and r bits away
+    uint64_t aboveHi = i - q >= 0 ? region[i - q] : 0;
+    uint64_t aboveLo = i - q - 1 >= 0 ? region[i - q - 1] : 0;
+    uint64_t belowLo = i + q < words ? region[i + q] : 0;
+    uint64_t belowHi = i + q + 1 < words ? region[i + q + 1] : 0;
+    g |= r ? (aboveHi << r) | (aboveLo >> (64 - r)) : aboveHi;
+    g |= r ? (belowLo >> r) | (belowHi << (64 - r)) : belowLo;
+
+    g = spreadInWord(g & passable[i], passable[i]);
+    if (g != w)
+    {
+        s.added += __builtin_popcountll(g & ~w);
+        s.lo = i < s.lo ? i : s.lo;
+        s.hi = i + 1 > s.hi ? i + 1 : s.hi;
+        region[i] = g;
+    }
+}
+
+// Forward then backward over [lo, hi). Each pass carries on past its end
+// for as long as words keep changing, so a region that is growing spreads
+// across the board within one call instead of a row per call.
+int sweepScalar(uint64_t *region, const uint64_t *passable, int words, int rowBits, int lo, int hi, SweepState &s)
+{
+    const int q = rowBits >> 6, r = rowBits & 63;
+    int end = hi;
+    for (int i = lo; i < end; i++)
+    {
+        sweepWord(region, passable, words, q, r, i, s);
+        if (s.hi + q + 1 > end)
+            end = s.hi + q + 1 < words ? s.hi + q + 1 : words;
+    }
+    int stop = lo;
+    for (int i = end - 1; i >= stop; i--)
+    {
+        sweepWord(region, passable, words, q, r, i, s);
+        if (s.lo - q - 1 < stop)
+            stop = s.lo - q - 1 > 0 ? s.lo - q - 1 : 0;
+    }
+    return s.added;
+}
+
+#if defined(FLOOD_FILL_AVX2)
+__attribute__((target("avx2"))) inline __m256i spreadInWords(__m256i g, __m256i p)
+{
+    __m256i up = g, pu = p;
+    __m256i down = g, pd = p;
+    for (int s = 1; s < 64; s <<= 1)
+    {
+        __m128i n = _mm_cvtsi32_si128(s);
+        up = _mm256_or_si256(up, _mm256_and_si256(pu, _mm256_sll_epi64(up, n)));
+        pu = _mm256_and_si256(pu, _mm256_sll_epi64(pu, n));
+        down = _mm256_or_si256(down, _mm256_and_si256(pd, _mm256_srl_epi64(down, n)));
+        pd = _mm256_and_si256(pd, _mm256_srl_epi64(pd, n));
+    }
+    return _mm256_or_si256(up, down);
+}
+
+// Words i..i+3 at once; their row-above and row-below sources must all be
+// in range. Shifts by 64 give zero in AVX2, so r = 0 needs no special case.
+__attribute__((target("avx2"))) inline void sweepBlock(uint64_t *region, const uint64_t *passable, int q, int r, int i,
+                                                       SweepState &s)
+{
+    const __m128i one = _mm_cvtsi32_si128(1), back = _mm_cvtsi32_si128(63);
+    const __m128i shiftR = _mm_cvtsi32_si128(r), shiftRest = _mm_cvtsi32_si128(64 - r);
+
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(region + i));
+    __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(region + i - 1));
+    __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(region + i + 1));
+    __m256i g = _mm256_or_si256(w, _mm256_or_si256(_mm256_sll_epi64(w, one), _mm256_srl_epi64(w, one)));
+    g = _mm256_or_si256(g, _mm256_or_si256(_mm256_srl_epi64(prev, back), _mm256_sll_epi64(next, back)));
+
+    __m256i aboveHi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(region + i - q));
+    __m256i aboveLo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(region + i - q - 1));
+    __m256i belowLo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(region + i + q));
+    __m256i belowHi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(region + i + q + 1));
+    g = _mm256_or_si256(g, _mm256_or_si256(_mm256_sll_epi64(aboveHi, shiftR), _mm256_srl_epi64(aboveLo, shiftRest)));
+    g = _mm256_or_si256(g, _mm256_or_si256(_mm256_srl_epi64(belowLo, shiftR), _mm256_sll_epi64(belowHi, shiftRest)));
+
+    __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(passable + i));
+    g = spreadInWords(_mm256_and_si256(g, p), p);
+
+    int same = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(g, w)));
+    if (same != 0xF)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(region + i), g);
+        uint64_t gw[4], ww[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(gw), g);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(ww), w);
+        for (int k = 0; k < 4; k++)
+            s.added += __builtin_popcountll(gw[k] & ~ww[k]);
+        int changed = ~same & 0xF;
+        int firstChanged = i + __builtin_ctz(changed), lastChanged = i + 31 - __builtin_clz(changed);
+        s.lo = firstChanged < s.lo ? firstChanged : s.lo;
+        s.hi = lastChanged + 1 > s.hi ? lastChanged + 1 : s.hi;
+    }
+}
+
+// sweepScalar four words at a time wherever sweepBlock's sources are in
+// range
+__attribute__((target("avx2"))) int sweepAvx2(uint64_t *region, const uint64_t *passable, int words, int rowBits,
+                                              int lo, int hi, SweepState &s)
+{
+    const int q = rowBits >> 6, r = rowBits & 63;
+    const int first = q + 1, last = words - q - 1; // Blocks may cover [first, last)
+    int end = hi;
+    for (int i = lo; i < end;)
+    {
+        if (i >= first && i + 4 <= last)
+        {
+            sweepBlock(region, passable, q, r, i, s);
+            i += 4;
+        }
+        else
+            sweepWord(region, passable, words, q, r, i++, s);
+        if (s.hi + q + 1 > end)
+            end = s.hi + q + 1 < words ? s.hi + q + 1 : words;
+    }
+    int stop = lo;
+    for (int i = end - 1; i >= stop;)
+    {
+        if (i - 3 >= first && i + 1 <= last)
+        {
+            sweepBlock(region, passable, q, r, i - 3, s);
+            i -= 4;
+        }
+        else
+            sweepWord(region, passable, words, q, r, i--, s);
+        if (s.lo - q - 1 < stop)
+            stop = s.lo - q - 1 > 0 ? s.lo - q - 1 : 0;
+    }
+    return s.added;
+}
+#endif
+
+typedef int (*SweepFn)(uint64_t *, const uint64_t *, int, int, int, int, SweepState &);
+
+SweepFn pickSweep()
+{
+#if defined(FLOOD_FILL_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return sweepAvx2;
+#endif
+    return sweepScalar;
+}
+
+// The sweep floodSweep() runs
+SweepFn sweep = pickSweep();
+
+} // namespace
+
+bool floodSweepScalarOnly(bool scalar)
+{
+    sweep = scalar ? sweepScalar : pickSweep();
+    return sweep != sweepScalar;
+}
+
+int floodSweep(uint64_t *region, const uint64_t *passable, int words, int rowBits, int lo, int hi, int *changedLo,
+               int *changedHi)
+{
+    SweepState s = {0, hi, lo};
+    sweep(region, passable, words, rowBits, lo, hi, s);
+    *changedLo = s.lo;
+    *changedHi = s.hi;
+    return s.added;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+
+#include "bitboard.h"
+#include "snake_sim.h"
+
+// Size of the free region around a cell, and whether the tail borders it
+struct Reach
+{
+    int size;           // Free cells reachable, the tail's cell not included
+    bool tailReachable; // The snake could follow its tail out of the region
+};
+
+// Flood fill of the free region from a candidate head cell, to spot
+// pockets too small for the body before moving into them. Free cells are a
+// bitboard: the walls are rasterized into a static mask once per rule set,
+// and each update() either replays the game's change log (one bit per
+// changed cell) or rebuilds from that mask minus the body.
+//
+// The fill itself (floodSweep) grows the region a word at a time: bits
+// come in from the words a row above and below and from the neighbouring
+// words, then spread along runs of free cells inside the word with
+// Kogge-Stone shifts. Sweeps start from the words near the last change and
+// run with AVX2 where the CPU has it (picked at run time). About 20 us to
+// fill an open 256 x 256 board.
+template <class Rules>
+class ReachableArea
+{
+public:
+    typedef SnakeGame<Rules> Game;
+    typedef BoardBits<Game::WIDTH, Game::HEIGHT, Rules::WRAP> Board;
+    typedef typename Board::Bits Bits;
+
+    ReachableArea() : tail(0), episode(0), tick(0), synced(false) { region.clear(); }
+
+    // Brings the free-cell mask up to date with game
+    void update(const Game &game);
+
+    // Fills from cell over the board as of the last update(), with the tail
+    // cell open. Stops once size reaches limit, so a caller that only needs
+    // "room for the body" can pass the body length. A cell that is neither
+    // free nor the tail gives {0, false}.
+    Reach from(int cell, int limit = INT_MAX);
+
+private:
+    static const Bits &wallFree();
+
+    Bits passable; // Empty or apple
+    Bits region;   // Scratch; all zero between calls
+    int tail;
+    uint32_t episode, tick;
+    bool synced;
+};
+
+// In-place growth of region over passable (both words long) for a board
+// rowBits cells wide whose edge cells are not passable: a forward and a
+// backward pass starting from words [lo, hi), each running on past its end
+// while words keep changing. Returns how many bits were added, 0 once the
+// region is complete; [*changedLo, *changedHi) is the range of words that
+// changed.
+int floodSweep(uint64_t *region, const uint64_t *passable, int words, int rowBits, int lo, int hi, int *changedLo,
+               int *changedHi);
+
+// Makes floodSweep() use the scalar sweep even where AVX2 is available
+// (scalar = true), or go back to the best the CPU has. Returns whether
+// AVX2 is in use afterwards. For tests; not while fills are running.
+bool floodSweepScalarOnly(bool scalar);
+
+#include "flood_fill_impl.h"
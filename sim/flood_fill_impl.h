@@ -0,0 +1,120 @@
+#pragma once
+
+// Member definitions for ReachableArea; included from flood_fill.h only.
+
+template <class Rules>
+const typename ReachableArea<Rules>::Bits &ReachableArea<Rules>::wallFree()
+{
+    struct Mask
+    {
+        Mask()
+        {
+            bits.clear();
+            const typename Game::Grid &walls = Game::wallGrid();
+            for (int i = 0; i < Game::CELLS; i++)
+            {
+                if (walls.at(i) != CELL_WALL)
+                    bits.set(i);
+            }
+        }
+        Bits bits;
+    };
+    static const Mask mask;
+    return mask.bits;
+}
+
+template <class Rules>
+void ReachableArea<Rules>::update(const Game &game)
+{
+    const typename Game::ChangeLog &log = game.changes();
+    const Segment &t = game.snake().tail();
+    tail = Game::Grid::index(t.x, t.z);
+
+    if (synced && game.episode() == episode && game.tick() == tick + 1 && !log.overflow)
+    {
+        for (int k = 0; k < log.count; k++)
+        {
+            int cell = log.cells[k];
+            CellType type = game.cells().at(cell);
+            if (type == CELL_EMPTY || type == CELL_APPLE)
+                passable.set(cell);
+            else
+                passable.reset(cell);
+        }
+    }
+    else
+    {
+        passable = wallFree();
+        const typename Game::Body &body = game.snake();
+        for (size_t k = 0; k < body.size(); k++)
+        {
+            // A head that ran into a wall isn't a body cell
+            int cell = Game::Grid::index(body[k].x, body[k].z);
+            if (game.cells().at(cell) == CELL_BODY)
+                passable.reset(cell);
+        }
+    }
+    episode = game.episode();
+    tick = game.tick();
+    synced = true;
+}
+
+template <class Rules>
+Reach ReachableArea<Rules>::from(int cell, int limit)
+{
+    Reach reach = {0, false};
+    if (!passable.test(cell) && cell != tail)
+        return reach;
+
+    bool tailFree = passable.test(tail);
+    passable.set(tail);
+    region.set(cell);
+    int count = 1;
+
+    if (Rules::WRAP)
+    {
+        // Small boards only; whole-board steps are cheap enough
+        Bits next;
+        while (count < limit)
+        {
+            Board::neighbours(region, next);
+            int added = 0;
+            for (int k = 0; k < Bits::WORDS; k++)
+            {
+                uint64_t w = (next.words[k] & passable.words[k]) | region.words[k];
+                added += __builtin_popcountll(w & ~region.words[k]);
+                region.words[k] = w;
+            }
+            if (added == 0)
+                break;
+            count += added;
+        }
+        reach.tailReachable = region.test(tail);
+        region.clear();
+    }
+    else
+    {
+        // Sweep only the words next to the last change, out to a row away
+        const int reachWords = Game::WIDTH / 64 + 2;
+        int lo = cell >> 6, hi = lo + 1;
+        int touchedLo = lo, touchedHi = hi;
+        while (count < limit)
+        {
+            int sweepLo = lo - reachWords > 0 ? lo - reachWords : 0;
+            int sweepHi = hi + reachWords < Bits::WORDS ? hi + reachWords : Bits::WORDS;
+            int added = floodSweep(region.words, passable.words, Bits::WORDS, Game::WIDTH, sweepLo, sweepHi, &lo, &hi);
+            if (added == 0)
+                break;
+            count += added;
+            touchedLo = lo < touchedLo ? lo : touchedLo;
+            touchedHi = hi > touchedHi ? hi : touchedHi;
+        }
+        reach.tailReachable = region.test(tail);
+        memset(region.words + touchedLo, 0, size_t(touchedHi - touchedLo) * 8);
+    }
+
+    if (!tailFree)
+        passable.reset(tail);
+    reach.size = count - (reach.tailReachable ? 1 : 0);
+    return reach;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cassert>
+
+#include "occupancy_grid.h"
+
+// Indexed set of grid cells apples may spawn on. Cells are kept densely in
+// an array and each cell remembers its slot, so insert, erase and picking a
+// uniform random member are all O(1) however full the board is.
+template <int CELLS>
+class FreeCellSet
+{
+public:
+    typedef CellIndex<CELLS> Index;
+    static constexpr Index ABSENT = Index(~Index(0));
+
+    FreeCellSet() { clear(); }
+
+    void clear()
+    {
+        count = 0;
+        for (int i = 0; i < CELLS; i++)
+            slot[i] = ABSENT;
+    }
+
+    bool contains(int cell) const { return slot[cell] != ABSENT; }
+
+    void insert(int cell)
+    {
+        if (slot[cell] != ABSENT)
+            return;
+        slot[cell] = Index(count);
+        cells[count++] = Index(cell);
+    }
+
+    // Swap-remove: the last member moves into the freed slot
+    void erase(int cell)
+    {
+        Index s = slot[cell];
+        if (s == ABSENT)
+            return;
+        assert(count > 0);
+        Index last = cells[--count];
+        cells[s] = last;
+        slot[last] = s;
+        slot[cell] = ABSENT;
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    int operator[](int i) const { return cells[i]; }
+
+    // Whether members and slots agree, as insert()/erase() keep them. For
+    // sets copied in from outside.
+    bool consistent() const
+    {
+        if (count < 0 || count > CELLS)
+            return false;
+        for (int i = 0; i < count; i++)
+        {
+            if (cells[i] >= CELLS || slot[cells[i]] != Index(i))
+                return false;
+        }
+        int members = 0;
+        for (int i = 0; i < CELLS; i++)
+            members += slot[i] != ABSENT;
+        return members == count;
+    }
+
+private:
+    Index cells[CELLS]; // Members, densely packed
+    Index slot[CELLS];  // Position of each cell in cells[], ABSENT if not a member
+    int count;
+};
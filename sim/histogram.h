@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Fixed-size log-linear histogram of unsigned 32-bit values, in the style
+// of HdrHistogram: values below 128 get a bucket each, and every power of
+// two above that is split into 64 buckets, so any value is recorded to
+// within 1/64 (about 1.6%). Recording is an index computation and an
+// increment with no allocation, and two histograms merge by adding their
+// buckets, so each thread can keep its own and combine them at the end.
+class Histogram
+{
+public:
+    static constexpr int SUB_BITS = 6;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (32 - SUB_BITS + 1) * SUB_COUNT;
+
+    Histogram() { clear(); }
+
+    void clear()
+    {
+        std::memset(counts, 0, sizeof(counts));
+        total = 0;
+        sum = 0;
+        lowest = UINT32_MAX;
+        highest = 0;
+    }
+
+    void record(uint32_t value)
+    {
+        counts[bucketOf(value)]++;
+        total++;
+        sum += value;
+        if (value < lowest)
+            lowest = value;
+        if (value > highest)
+            highest = value;
+    }
+
+    void merge(const Histogram &other)
+    {
+        for (int i = 0; i < BUCKETS; i++)
+            counts[i] += other.counts[i];
+        total += other.total;
+        sum += other.sum;
+        if (other.lowest < lowest)
+            lowest = other.lowest;
+        if (other.highest > highest)
+            highest = other.highest;
+    }
+
+    uint64_t count() const { return total; }
+    uint32_t min() const { return total ? lowest : 0; }
+    uint32_t max() const { return highest; }
+    double mean() const { return total ? double(sum) / double(total) : 0.0; }
+
+    // Smallest recorded value v (to bucket precision) with at least p
+    // percent of the values <= v
+    uint32_t percentile(double p) const
+    {
+        if (total == 0)
+            return 0;
+        uint64_t rank = uint64_t(p / 100.0 * double(total) + 0.5);
+        if (rank < 1)
+            rank = 1;
+        if (rank > total)
+            rank = total;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                // Top of the bucket, but never past what was recorded
+                uint32_t top = highestIn(i);
+                return top < highest ? top : highest;
+            }
+        }
+        return highest;
+    }
+
+private:
+    // shift = how far the value is above the exact range; the top
+    // SUB_BITS + 1 bits of the value pick the bucket within that range
+    static int bucketOf(uint32_t value)
+    {
+        int shift = 0;
+        if (value >= 2 * SUB_COUNT)
+            shift = (31 - __builtin_clz(value)) - SUB_BITS;
+        return shift * SUB_COUNT + int(value >> shift);
+    }
+
+    static uint32_t highestIn(int bucket)
+    {
+        if (bucket < 2 * SUB_COUNT)
+            return uint32_t(bucket);
+        int shift = bucket / SUB_COUNT - 1;
+        uint32_t top = uint32_t(bucket - shift * SUB_COUNT);
+        return uint32_t(((uint64_t(top) + 1) << shift) - 1);
+    }
+
+    uint64_t counts[BUCKETS];
+    uint64_t total;
+    uint64_t sum;
+    uint32_t lowest, highest;
+};
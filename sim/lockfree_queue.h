@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "snake_body.h"
+
+// Bounded lock-free queues over preallocated rings. Capacity is rounded up
+// to a power of two and fixed at construction; push() fails rather than
+// grow when the ring is full, and pop() fails when it is empty. Neither
+// ever allocates or blocks.
+
+// Head or tail position, on its own cache line so producer and consumer
+// don't false-share
+struct alignas(64) QueueCounter
+{
+    explicit QueueCounter(uint64_t v) : value(v) {}
+    std::atomic<uint64_t> value;
+};
+
+// One producer thread, one consumer thread
+template <class T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) : mask(ringCapacity(capacity) - 1), items(mask + 1), head(0), tail(0) {}
+
+    bool push(const T &item)
+    {
+        uint64_t t = tail.value.load(std::memory_order_relaxed);
+        if (t - head.value.load(std::memory_order_acquire) > mask)
+            return false;
+        items[t & mask] = item;
+        tail.value.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        uint64_t h = head.value.load(std::memory_order_relaxed);
+        if (h == tail.value.load(std::memory_order_acquire))
+            return false;
+        item = items[h & mask];
+        head.value.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head.value.load(std::memory_order_acquire) == tail.value.load(std::memory_order_acquire);
+    }
+
+private:
+    size_t mask;
+    std::vector<T> items;
+    QueueCounter head; // Next slot to pop
+    QueueCounter tail; // Next slot to push
+};
+
+// Any number of producer threads, one consumer thread. Each slot carries a
+// sequence number (Vyukov's bounded queue): producers claim a slot with a
+// CAS on the tail and publish it by bumping its sequence.
+template <class T>
+class MpscQueue
+{
+public:
+    explicit MpscQueue(size_t capacity) : mask(ringCapacity(capacity) - 1), slots(mask + 1), head(0), tail(0)
+    {
+        for (size_t i = 0; i <= mask; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const T &item)
+    {
+        uint64_t t = tail.value.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = slots[t & mask];
+            uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+            if (seq == t)
+            {
+                if (tail.value.compare_exchange_weak(t, t + 1, std::memory_order_relaxed))
+                {
+                    slot.item = item;
+                    slot.sequence.store(t + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (seq < t)
+                return false; // Full: the consumer hasn't freed this slot yet
+            else
+                t = tail.value.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool pop(T &item)
+    {
+        uint64_t h = head.value.load(std::memory_order_relaxed);
+        Slot &slot = slots[h & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != h + 1)
+            return false;
+        item = slot.item;
+        slot.sequence.store(h + mask + 1, std::memory_order_release);
+        head.value.store(h + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : sequence(0), item() {}
+        std::atomic<uint64_t> sequence;
+        T item;
+    };
+
+    size_t mask;
+    std::vector<Slot> slots;
+    QueueCounter head;
+    QueueCounter tail;
+};
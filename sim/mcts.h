@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "episode_runner.h"
+#include "rng.h"
+#include "snake_sim.h"
+#include "transposition_table.h"
+#include "work_stealing_pool.h"
+
+// Search settings for MctsAutopilot
+struct MctsConfig
+{
+    int budgetMs = 100;         // Thinking time per move
+    int nodes = 1 << 19;        // Tree capacity, allocated up front (twice)
+    int rolloutTicks = 48;      // Rollout length past the end of the tree
+    bool greedyRollouts = true; // GreedyPolicy rollouts; else random safe moves
+    double exploration = 1.5;   // UCT constant
+    double discount = 0.97;     // Per tick, on apples and on dying
+    double deathPenalty = 4.0;  // Value of dying, in apples
+    int virtualLoss = 3;        // Losing visits a thread adds on its way down
+    size_t tableBytes = 0;      // Transposition table of rollout values; 0 for none
+};
+
+// Monte Carlo tree search player. Every playout restores the position from
+// a snapshot, follows UCT down the tree over the moves that survive the
+// next tick (safeMoves()), adds the children of the leaf it reaches and
+// plays a short rollout from there. Its value is the discounted apples
+// eaten along the way, less deathPenalty for dying.
+//
+// With a pool, every worker runs playouts on the one shared tree until the
+// time budget is spent. Nodes are updated with atomics and a thread on its
+// way down adds virtualLoss losing visits to each node, so the others
+// spread out instead of all following the same path. Children are added by
+// whichever thread wins a CAS on their parent; the rest play from the leaf.
+//
+// The game is deterministic given its generator, which the snapshot
+// carries, so a node is an exact position. After a move, the subtree under
+// it stays in use for the next call when the game did play that move. It is
+// copied into a second buffer with the rest of the tree dropped, so memory
+// stays fixed however long the game runs.
+//
+// With tableBytes set, rollout values are also kept by position hash
+// (SnakeGame::hash()) in a TranspositionTable all the threads share, and a
+// leaf reached again by another path (or from the old tree, or by a thread
+// that lost the race to expand it) is valued by the mean of every rollout
+// from that position so far.
+//
+// A policy for runEpisodes(), or called once per tick like BfsAutopilot.
+// runEpisodes() already gives each worker its own copy, so copies search
+// on their own thread; a pool only serves a player driven from one thread.
+template <class Rules>
+class MctsAutopilot
+{
+public:
+    typedef SnakeGame<Rules> Game;
+
+    // pool = nullptr searches on the calling thread only
+    explicit MctsAutopilot(const MctsConfig &config = MctsConfig(), WorkStealingPool *pool = nullptr);
+
+    // Same settings, empty tree and no pool (runEpisodes() copies policies
+    // onto its own workers, and a WorkStealingPool takes one run() at a time)
+    MctsAutopilot(const MctsAutopilot &other) : MctsAutopilot(other.config, nullptr) {}
+    MctsAutopilot &operator=(const MctsAutopilot &) = delete;
+
+    void reset(uint64_t seed);
+    Direction operator()(const Game &game);
+
+    // Playouts in the last search, and the root visits it started with
+    // from the previous tick's tree
+    uint64_t playouts() const { return lastPlayouts; }
+    int32_t reusedVisits() const { return lastReused; }
+
+private:
+    static constexpr int32_t LEAF = -1;      // No children yet
+    static constexpr int32_t EXPANDING = -2; // Another thread is adding them
+    static constexpr int32_t FULL = -3;      // Out of nodes; stays a leaf
+    static constexpr int MAX_DEPTH = 256;
+    static constexpr double VALUE_SCALE = 65536.0; // Fixed point for value sums
+
+    struct Node
+    {
+        std::atomic<int32_t> visits;
+        std::atomic<int32_t> pending; // Threads below this node right now
+        std::atomic<int64_t> valueSum;
+        std::atomic<int32_t> firstChild; // Children are contiguous
+        uint8_t childCount;
+        uint8_t move;
+    };
+
+    // One per worker, on its own cache lines
+    struct alignas(64) Scratch
+    {
+        Game game;
+        Rng rng;
+        GreedyPolicy greedy;
+        uint64_t playouts;
+        int32_t path[MAX_DEPTH + 1];
+    };
+
+    void search(Scratch &s, int64_t deadline);
+    void playout(Scratch &s);
+    int32_t select(const Node &parent) const;
+    int32_t expand(Node &node, const Game &game);
+    double rollout(Scratch &s, double weight);
+    double leafValue(Scratch &s);
+    bool keepSubtree(const Game &game);
+    void clearTree();
+
+    MctsConfig config;
+    WorkStealingPool *pool;
+    std::unique_ptr<Node[]> nodes;   // Tree in use
+    std::unique_ptr<Node[]> spare;   // Target when keeping a subtree
+    std::vector<int32_t> copiedFrom; // Compaction scratch
+    std::atomic<int32_t> used;       // Nodes allocated
+    std::vector<Scratch> scratch;
+    std::unique_ptr<TranspositionTable> table; // Null without tableBytes
+
+    typename Game::Snapshot rootState;
+    Game expected;      // The position the chosen move leads to
+    int32_t nextRoot;   // Its node, or -1 if there is no tree to keep
+    uint64_t lastPlayouts;
+    int32_t lastReused;
+};
+
+#include "mcts_impl.h"
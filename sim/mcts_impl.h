@@ -0,0 +1,320 @@
+#pragma once
+
+// Member definitions for MctsAutopilot; included from mcts.h only.
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+template <class Rules>
+MctsAutopilot<Rules>::MctsAutopilot(const MctsConfig &config, WorkStealingPool *pool)
+    : config(config), pool(pool), nodes(new Node[config.nodes]), spare(new Node[config.nodes]),
+      copiedFrom(config.nodes), used(0), scratch(pool ? pool->size() : 1), nextRoot(-1), lastPlayouts(0),
+      lastReused(0)
+{
+    if (config.tableBytes)
+        table.reset(new TranspositionTable(config.tableBytes));
+    reset(0);
+}
+
+template <class Rules>
+void MctsAutopilot<Rules>::reset(uint64_t seed)
+{
+    for (size_t w = 0; w < scratch.size(); w++)
+    {
+        scratch[w].rng = Rng::forStream(seed, unsigned(w));
+        scratch[w].playouts = 0;
+    }
+    if (table)
+        table->clear();
+    clearTree();
+}
+
+template <class Rules>
+void MctsAutopilot<Rules>::clearTree()
+{
+    Node &root = nodes[0];
+    root.visits.store(0, std::memory_order_relaxed);
+    root.pending.store(0, std::memory_order_relaxed);
+    root.valueSum.store(0, std::memory_order_relaxed);
+    root.firstChild.store(LEAF, std::memory_order_relaxed);
+    root.childCount = 0;
+    root.move = 0;
+    used.store(1, std::memory_order_relaxed);
+    nextRoot = -1;
+}
+
+template <class Rules>
+Direction MctsAutopilot<Rules>::operator()(const Game &game)
+{
+    typedef std::chrono::steady_clock Clock;
+    int64_t deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count() +
+                       int64_t(config.budgetMs) * 1000000;
+
+    if (!keepSubtree(game))
+        clearTree();
+    lastReused = nodes[0].visits.load(std::memory_order_relaxed);
+    game.save(rootState);
+
+    for (Scratch &s : scratch)
+        s.playouts = 0;
+    if (pool)
+    {
+        // One search loop per worker, all on the same tree
+        auto run = [&](uint64_t, unsigned worker) { search(scratch[worker], deadline); };
+        pool->run(pool->size(), run);
+    }
+    else
+        search(scratch[0], deadline);
+
+    lastPlayouts = 0;
+    for (const Scratch &s : scratch)
+        lastPlayouts += s.playouts;
+
+    // Most visited move; keep its subtree for the next call
+    const Node &root = nodes[0];
+    int32_t first = root.firstChild.load(std::memory_order_relaxed);
+    if (first < 0 || root.childCount == 0)
+    {
+        nextRoot = -1;
+        return game.direction();
+    }
+    int32_t best = first;
+    for (int k = 1; k < root.childCount; k++)
+    {
+        if (nodes[first + k].visits.load(std::memory_order_relaxed) > nodes[best].visits.load(std::memory_order_relaxed))
+            best = first + k;
+    }
+    Direction move = Direction(nodes[best].move);
+    expected.restore(rootState);
+    expected.step(move);
+    nextRoot = best;
+    return move;
+}
+
+template <class Rules>
+void MctsAutopilot<Rules>::search(Scratch &s, int64_t deadline)
+{
+    typedef std::chrono::steady_clock Clock;
+    do
+    {
+        playout(s);
+        s.playouts++;
+    } while (std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count() < deadline);
+}
+
+template <class Rules>
+void MctsAutopilot<Rules>::playout(Scratch &s)
+{
+    Game &game = s.game;
+    game.restore(rootState);
+
+    // Down the tree, marking each node as having a thread below it
+    double value = 0.0, weight = 1.0;
+    bool over = false;
+    int length = 0;
+    int32_t index = 0;
+    for (;;)
+    {
+        Node &node = nodes[index];
+        node.pending.fetch_add(1, std::memory_order_relaxed);
+        s.path[length++] = index;
+        if (over || length == MAX_DEPTH)
+            break;
+
+        int32_t first = node.firstChild.load(std::memory_order_acquire);
+        if (first == LEAF && (index == 0 || node.visits.load(std::memory_order_relaxed) > 0))
+            first = expand(node, game);
+        if (first < 0 || node.childCount == 0)
+            break;
+
+        index = select(node);
+        int score = game.score();
+        if (game.step(Direction(nodes[index].move)) == GAME_OVER)
+        {
+            value -= weight * config.deathPenalty;
+            over = true;
+        }
+        else
+            value += weight * (game.score() - score);
+        weight *= config.discount;
+    }
+    if (!over)
+        value += table ? weight * leafValue(s) : rollout(s, weight);
+
+    int64_t fixed = int64_t(value * VALUE_SCALE);
+    for (int k = 0; k < length; k++)
+    {
+        Node &node = nodes[s.path[k]];
+        node.valueSum.fetch_add(fixed, std::memory_order_relaxed);
+        node.visits.fetch_add(1, std::memory_order_relaxed);
+        node.pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// UCT over the children, counting each pending thread as virtualLoss
+// visits that died
+template <class Rules>
+int32_t MctsAutopilot<Rules>::select(const Node &parent) const
+{
+    const double loss = config.virtualLoss;
+    int32_t first = parent.firstChild.load(std::memory_order_relaxed);
+    double total = parent.visits.load(std::memory_order_relaxed) + loss * parent.pending.load(std::memory_order_relaxed);
+    double logTotal = std::log(total + 1.0);
+
+    int32_t best = first;
+    double bestScore = -HUGE_VAL;
+    for (int k = 0; k < parent.childCount; k++)
+    {
+        const Node &child = nodes[first + k];
+        double pending = loss * child.pending.load(std::memory_order_relaxed);
+        double n = child.visits.load(std::memory_order_relaxed) + pending;
+        if (n == 0.0)
+            return first + k; // Every child gets one playout first
+        double sum = double(child.valueSum.load(std::memory_order_relaxed)) / VALUE_SCALE;
+        double score = (sum - pending * config.deathPenalty) / n + config.exploration * std::sqrt(logTotal / n);
+        if (score > bestScore)
+        {
+            best = first + k;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+// Adds a child for each move that survives the next tick. Returns the first
+// child, or EXPANDING / FULL if this thread can't descend.
+template <class Rules>
+int32_t MctsAutopilot<Rules>::expand(Node &node, const Game &game)
+{
+    int32_t state = LEAF;
+    if (!node.firstChild.compare_exchange_strong(state, EXPANDING, std::memory_order_acquire))
+        return state;
+
+    unsigned safe = game.safeMoves();
+    int count = __builtin_popcount(safe);
+    int32_t first = used.load(std::memory_order_relaxed);
+    if (first + count <= config.nodes)
+        first = used.fetch_add(count, std::memory_order_relaxed);
+    if (first + count > config.nodes)
+    {
+        node.firstChild.store(FULL, std::memory_order_release);
+        return FULL;
+    }
+
+    int32_t child = first;
+    for (int d = 0; d < 4; d++)
+    {
+        if (!((safe >> d) & 1))
+            continue;
+        Node &c = nodes[child++];
+        c.visits.store(0, std::memory_order_relaxed);
+        c.pending.store(0, std::memory_order_relaxed);
+        c.valueSum.store(0, std::memory_order_relaxed);
+        c.firstChild.store(LEAF, std::memory_order_relaxed);
+        c.childCount = 0;
+        c.move = uint8_t(d);
+    }
+    node.childCount = uint8_t(count);
+    node.firstChild.store(first, std::memory_order_release);
+    return first;
+}
+
+// Plays on from s.game for up to rolloutTicks: greedy with one move in
+// eight random, or random safe moves throughout
+template <class Rules>
+double MctsAutopilot<Rules>::rollout(Scratch &s, double weight)
+{
+    Game &game = s.game;
+    double value = 0.0;
+    for (int t = 0; t < config.rolloutTicks; t++)
+    {
+        Direction dir;
+        if (config.greedyRollouts && s.rng.below(8) != 0)
+            dir = s.greedy(game);
+        else
+        {
+            unsigned safe = game.safeMoves();
+            if (!safe)
+                dir = game.direction();
+            else
+            {
+                for (uint32_t k = s.rng.below(__builtin_popcount(safe)); k > 0; k--)
+                    safe &= safe - 1;
+                dir = Direction(__builtin_ctz(safe));
+            }
+        }
+        int score = game.score();
+        if (game.step(dir) == GAME_OVER)
+            return value - weight * config.deathPenalty;
+        value += weight * (game.score() - score);
+        weight *= config.discount;
+    }
+    return value;
+}
+
+// A rollout from s.game, folded into the running mean the table keeps for
+// the position. Concurrent updates of one position may lose a sample.
+template <class Rules>
+double MctsAutopilot<Rules>::leafValue(Scratch &s)
+{
+    uint64_t key = s.game.hash();
+    double value = rollout(s, 1.0);
+
+    uint64_t data;
+    uint32_t samples = 1;
+    if (table->find(key, data))
+    {
+        uint32_t seen = TranspositionTable::weightOf(data);
+        uint32_t bits = uint32_t(TranspositionTable::payloadOf(data));
+        float mean;
+        memcpy(&mean, &bits, sizeof(mean));
+        value = (double(mean) * seen + value) / (seen + 1);
+        samples = seen < UINT16_MAX ? seen + 1 : seen;
+    }
+    float mean = float(value);
+    uint32_t bits;
+    memcpy(&bits, &mean, sizeof(bits));
+    table->store(key, TranspositionTable::pack(uint16_t(samples), bits));
+    return value;
+}
+
+// If game is where the last chosen move led, makes that move's subtree the
+// whole tree: copied breadth first into the spare buffer, so its nodes end
+// up at the front and the rest of the old tree is dropped
+template <class Rules>
+bool MctsAutopilot<Rules>::keepSubtree(const Game &game)
+{
+    if (nextRoot < 0 || game.state() != PLAYING || game.episode() != expected.episode() ||
+        game.tick() != expected.tick() || game.score() != expected.score() ||
+        game.direction() != expected.direction() ||
+        memcmp(game.cells().data(), expected.cells().data(), Game::CELLS) != 0)
+        return false;
+
+    copiedFrom[0] = nextRoot;
+    int32_t end = 1;
+    for (int32_t i = 0; i < end; i++)
+    {
+        const Node &src = nodes[copiedFrom[i]];
+        Node &dst = spare[i];
+        dst.visits.store(src.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        dst.pending.store(0, std::memory_order_relaxed);
+        dst.valueSum.store(src.valueSum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        dst.childCount = src.childCount;
+        dst.move = src.move;
+
+        int32_t first = src.firstChild.load(std::memory_order_relaxed);
+        if (first < 0)
+            dst.firstChild.store(LEAF, std::memory_order_relaxed); // A full tree may have room now
+        else
+        {
+            dst.firstChild.store(end, std::memory_order_relaxed);
+            for (int k = 0; k < src.childCount; k++)
+                copiedFrom[end++] = first + k;
+        }
+    }
+    nodes.swap(spare);
+    used.store(end, std::memory_order_relaxed);
+    nextRoot = -1;
+    return true;
+}
@@ -0,0 +1,151 @@
+#include "observation.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void encodePlanes(const uint8_t *grid, int cells, int head, uint8_t *planes)
+{
+    uint8_t *wall = planes;
+    uint8_t *body = planes + cells;
+    uint8_t *headPlane = planes + 2 * cells;
+    uint8_t *apple = planes + 3 * cells;
+
+    int i = 0;
+#if defined(__SSE2__)
+    // 16 cells per iteration: compare against each cell type, turn the
+    // 0xff masks into 0/1
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i wallType = _mm_set1_epi8(CELL_WALL);
+    const __m128i bodyType = _mm_set1_epi8(CELL_BODY);
+    const __m128i appleType = _mm_set1_epi8(CELL_APPLE);
+    for (; i + 16 <= cells; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(grid + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(wall + i), _mm_and_si128(_mm_cmpeq_epi8(v, wallType), one));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(body + i), _mm_and_si128(_mm_cmpeq_epi8(v, bodyType), one));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(apple + i), _mm_and_si128(_mm_cmpeq_epi8(v, appleType), one));
+    }
+#endif
+    for (; i < cells; i++)
+    {
+        wall[i] = grid[i] == CELL_WALL;
+        body[i] = grid[i] == CELL_BODY;
+        apple[i] = grid[i] == CELL_APPLE;
+    }
+
+    memset(headPlane, 0, size_t(cells));
+    headPlane[head] = 1;
+}
+
+void encodePlanesPacked(const uint8_t *grid, int cells, int head, uint8_t *planes)
+{
+    int bytes = packedPlaneBytes(cells);
+    uint8_t *wall = planes;
+    uint8_t *body = planes + bytes;
+    uint8_t *headPlane = planes + 2 * bytes;
+    uint8_t *apple = planes + 3 * bytes;
+
+    int i = 0;
+#if defined(__SSE2__)
+    // 16 cells per iteration: movemask turns each compare into 16 bits
+    const __m128i wallType = _mm_set1_epi8(CELL_WALL);
+    const __m128i bodyType = _mm_set1_epi8(CELL_BODY);
+    const __m128i appleType = _mm_set1_epi8(CELL_APPLE);
+    for (; i + 16 <= cells; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(grid + i));
+        uint16_t w = uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, wallType)));
+        uint16_t b = uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, bodyType)));
+        uint16_t a = uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, appleType)));
+        memcpy(wall + i / 8, &w, 2);
+        memcpy(body + i / 8, &b, 2);
+        memcpy(apple + i / 8, &a, 2);
+    }
+#endif
+    // Tail cells (and the whole plane without SSE2), a byte at a time
+    for (int byte = i / 8; byte < bytes; byte++)
+    {
+        uint8_t w = 0, b = 0, a = 0;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            int cell = byte * 8 + bit;
+            if (cell >= cells)
+                break;
+            w |= uint8_t((grid[cell] == CELL_WALL) << bit);
+            b |= uint8_t((grid[cell] == CELL_BODY) << bit);
+            a |= uint8_t((grid[cell] == CELL_APPLE) << bit);
+        }
+        wall[byte] = w;
+        body[byte] = b;
+        apple[byte] = a;
+    }
+
+    memset(headPlane, 0, size_t(bytes));
+    headPlane[head >> 3] = uint8_t(1u << (head & 7));
+}
+
+EgoWindow::EgoWindow(int size, int w, int h, bool wraps)
+    : k(size | 1), width(w), height(h), wrap(wraps)
+{
+    // Forward and right-hand unit vectors for UP, DOWN, LEFT, RIGHT
+    static const int FX[4] = {0, 0, -1, 1};
+    static const int FZ[4] = {-1, 1, 0, 0};
+    static const int RX[4] = {1, -1, 0, 0};
+    static const int RZ[4] = {0, 0, -1, 1};
+
+    int half = k / 2;
+    for (int d = 0; d < 4; d++)
+    {
+        dx[d].resize(size_t(k * k));
+        dz[d].resize(size_t(k * k));
+        offset[d].resize(size_t(k * k));
+        for (int row = 0; row < k; row++)
+        {
+            for (int col = 0; col < k; col++)
+            {
+                int ahead = half - row, right = col - half;
+                int i = row * k + col;
+                dx[d][i] = int16_t(FX[d] * ahead + RX[d] * right);
+                dz[d][i] = int16_t(FZ[d] * ahead + RZ[d] * right);
+                offset[d][i] = dz[d][i] * width + dx[d][i];
+            }
+        }
+    }
+}
+
+void EgoWindow::extract(const uint8_t *grid, int headX, int headZ, Direction dir, uint8_t *out) const
+{
+    const int16_t *ox = dx[dir].data();
+    const int16_t *oz = dz[dir].data();
+    const int32_t *off = offset[dir].data();
+    int n = k * k;
+    int half = k / 2;
+
+    // Fast path: window entirely on the board, a pure indexed gather
+    if (headX - half >= 0 && headX + half < width && headZ - half >= 0 && headZ + half < height)
+    {
+        const uint8_t *center = grid + headZ * width + headX;
+        for (int i = 0; i < n; i++)
+            out[i] = center[off[i]];
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+        {
+            int x = headX + ox[i], z = headZ + oz[i];
+            if (wrap)
+            {
+                x = ((x % width) + width) % width;
+                z = ((z % height) + height) % height;
+                out[i] = grid[z * width + x];
+            }
+            else
+            {
+                bool inside = unsigned(x) < unsigned(width) && unsigned(z) < unsigned(height);
+                out[i] = inside ? grid[z * width + x] : uint8_t(CELL_WALL);
+            }
+        }
+    }
+    out[half * k + half] = OBS_CELL_HEAD;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "snake_sim.h"
+
+// Board observations as stacked planes, one per channel, each plane one
+// value per cell in grid order (z major). Planes are either one byte per
+// cell (0/1) or bit-packed, eight cells per byte, lowest bit first.
+enum ObsPlane
+{
+    PLANE_WALL,
+    PLANE_BODY,
+    PLANE_HEAD,
+    PLANE_APPLE,
+    PLANE_AGE, // Optional: ticks until the segment's cell frees (uint8 planes only)
+    PLANE_COUNT
+};
+
+inline int packedPlaneBytes(int cells)
+{
+    return (cells + 7) / 8;
+}
+
+// Full encode straight from grid bytes (CellType per cell) plus the head's
+// cell index; SSE2 compares when available. Writes the wall, body, head and
+// apple planes.
+void encodePlanes(const uint8_t *grid, int cells, int head, uint8_t *planes);
+void encodePlanesPacked(const uint8_t *grid, int cells, int head, uint8_t *planes);
+
+// Head marker in cell-code observations, next after the CellType values
+const uint8_t OBS_CELL_HEAD = 4;
+
+// K x K window of cell codes centered on the head and turned so the snake
+// always faces up the window: row 0 is furthest ahead, columns run from the
+// snake's left to its right. Cells off a walled board read as wall; on a
+// wrapping board the window wraps too. Offsets for each heading are worked
+// out once, so extracting is a plain gather whose size and cost depend on K
+// only, never on the board.
+class EgoWindow
+{
+public:
+    // k is rounded up to odd so the head sits on the center cell
+    EgoWindow(int k, int width, int height, bool wrap);
+
+    int size() const { return k * k; }
+
+    // Writes size() cell codes (CellType, OBS_CELL_HEAD at the center)
+    void extract(const uint8_t *grid, int headX, int headZ, Direction dir, uint8_t *out) const;
+
+    template <class Rules>
+    void extract(const SnakeGame<Rules> &game, uint8_t *out) const
+    {
+        const Segment &head = game.snake().head();
+        extract(game.cells().data(), head.x, head.z, game.direction(), out);
+    }
+
+private:
+    int k;
+    int width, height;
+    bool wrap;
+    std::vector<int16_t> dx[4], dz[4]; // Board offset of each window cell, per heading
+    std::vector<int32_t> offset[4];    // Same as a grid index delta
+};
+
+// Keeps one game's planes up to date in a caller-owned buffer. The first
+// call (and any call after a reset, a skipped tick or a different buffer)
+// does a full encode; after that each tick only rewrites the cells the
+// game's change log lists, plus the old and new head.
+template <class Rules>
+class PlaneEncoder
+{
+public:
+    typedef SnakeGame<Rules> Game;
+
+    explicit PlaneEncoder(bool packed = false, bool bodyAge = false)
+        : packedBits(packed && !bodyAge), withAge(bodyAge), lastOut(nullptr)
+    {
+    }
+
+    int channels() const { return withAge ? 5 : 4; }
+    int planeBytes() const { return packedBits ? packedPlaneBytes(Game::CELLS) : Game::CELLS; }
+    int size() const { return channels() * planeBytes(); }
+
+    void encode(const Game &game, uint8_t *out)
+    {
+        const Segment &h = game.snake().head();
+        bool incremental = follows(game.changes(), game.episode(), game.tick(), out);
+        encode(game.cells().data(), Game::Grid::index(h.x, h.z), game.changes(), game.episode(), game.tick(), out);
+        if (withAge)
+            writeAges(game, out, incremental);
+    }
+
+    // Same from the parts of a game kept elsewhere (BatchEnv): its grid
+    // bytes, head cell, change log, episode and tick. No age plane.
+    void encode(const uint8_t *grid, int head, const typename Game::ChangeLog &log, uint32_t episode,
+                uint32_t tick, uint8_t *out)
+    {
+        if (follows(log, episode, tick, out))
+        {
+            for (int i = 0; i < log.count; i++)
+                writeCell(grid, out, log.cells[i]);
+            writeBit(out, PLANE_HEAD, lastHead, 0);
+            writeBit(out, PLANE_HEAD, head, 1);
+        }
+        else if (packedBits)
+        {
+            encodePlanesPacked(grid, Game::CELLS, head, out);
+        }
+        else
+        {
+            encodePlanes(grid, Game::CELLS, head, out);
+        }
+
+        lastOut = out;
+        lastEpisode = episode;
+        lastTick = tick;
+        lastHead = head;
+    }
+
+private:
+    // Whether out holds the planes of the tick just before this one
+    bool follows(const typename Game::ChangeLog &log, uint32_t episode, uint32_t tick, const uint8_t *out) const
+    {
+        return out == lastOut && episode == lastEpisode && tick == lastTick + 1 && !log.overflow;
+    }
+
+    void writeBit(uint8_t *out, int plane, int cell, uint8_t value) const
+    {
+        if (packedBits)
+        {
+            uint8_t &byte = out[plane * planeBytes() + (cell >> 3)];
+            uint8_t bit = uint8_t(1u << (cell & 7));
+            byte = value ? uint8_t(byte | bit) : uint8_t(byte & ~bit);
+        }
+        else
+        {
+            out[plane * planeBytes() + cell] = value;
+        }
+    }
+
+    void writeCell(const uint8_t *grid, uint8_t *out, int cell) const
+    {
+        CellType type = CellType(grid[cell]);
+        writeBit(out, PLANE_WALL, cell, type == CELL_WALL);
+        writeBit(out, PLANE_BODY, cell, type == CELL_BODY);
+        writeBit(out, PLANE_APPLE, cell, type == CELL_APPLE);
+    }
+
+    // Every segment's age moves each tick, so this plane is rewritten along
+    // the body: O(length), and only paid for when asked for. Cells the body
+    // left are in the change log, so only a full encode clears the whole
+    // plane. Ages count the growth still pending, as ticksUntilFree() does.
+    void writeAges(const Game &game, uint8_t *out, bool incremental) const
+    {
+        uint8_t *age = out + PLANE_AGE * planeBytes();
+        if (incremental)
+        {
+            const typename Game::ChangeLog &log = game.changes();
+            for (int i = 0; i < log.count; i++)
+                age[log.cells[i]] = 0;
+        }
+        else
+        {
+            memset(age, 0, Game::CELLS);
+        }
+        const typename Game::Body &body = game.snake();
+        for (size_t i = 0; i < body.size(); i++)
+        {
+            int cell = Game::Grid::index(body[i].x, body[i].z);
+            int left = game.ticksUntilFree(cell);
+            age[cell] = uint8_t(left <= 0 ? 0 : left < 255 ? left : 255);
+        }
+    }
+
+    bool packedBits;
+    bool withAge;
+    uint8_t *lastOut;
+    uint32_t lastEpisode;
+    uint32_t lastTick;
+    int lastHead;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// What sits in a grid cell
+enum CellType : uint8_t
+{
+    CELL_EMPTY,
+    CELL_WALL,
+    CELL_BODY,
+    CELL_APPLE
+};
+
+// Smallest unsigned type that can index every cell of a board and still
+// have one value left over as a sentinel
+template <int CELLS>
+using CellIndex = typename std::conditional<
+    (CELLS < 255), uint8_t,
+    typename std::conditional<(CELLS < 65535), uint16_t, uint32_t>::type>::type;
+
+// One byte per cell of a WIDTH x HEIGHT board, x and z in local grid
+// coordinates (0 to WIDTH - 1). There is no bounds check: walled boards
+// have wall cells all round the edge and wrapping boards fold coordinates
+// back in before they get here, so a head can never step off the grid.
+template <int WIDTH, int HEIGHT>
+class OccupancyGrid
+{
+public:
+    static constexpr int CELLS = WIDTH * HEIGHT;
+
+    OccupancyGrid() { clear(); }
+
+    void clear() { memset(cells, CELL_EMPTY, sizeof(cells)); }
+
+    CellType at(int x, int z) const { return CellType(cells[index(x, z)]); }
+    CellType at(int cell) const { return CellType(cells[cell]); }
+
+    void set(int x, int z, CellType type) { cells[index(x, z)] = type; }
+    void set(int cell, CellType type) { cells[cell] = type; }
+
+    // Raw bytes, row by row, for observation and search code
+    const uint8_t *data() const { return cells; }
+
+    static constexpr int index(int x, int z) { return z * WIDTH + x; }
+    static constexpr int cellX(int index) { return index % WIDTH; }
+    static constexpr int cellZ(int index) { return index / WIDTH; }
+
+private:
+    uint8_t cells[CELLS];
+};
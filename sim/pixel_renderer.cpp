@@ -0,0 +1,258 @@
+#include "pixel_renderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "occupancy_grid.h"
+
+namespace
+{
+// Same camera and lens as display() and reshape()
+const float EYE[3] = {0.0f, 18.0f, 22.0f};
+const float FOV_Y = 45.0f;
+
+// Box sizes and heights as drawScene() draws them
+const float WALL_HEIGHT = 1.5f;
+const float SEGMENT_SIZE = 0.8f;
+const float SEGMENT_Y = 0.5f;
+const float APPLE_SIZE = 0.6f;
+
+enum Face
+{
+    FACE_TOP,
+    FACE_FRONT,
+    FACE_RIGHT,
+    FACE_LEFT
+};
+
+uint32_t rgb(float r, float g, float b)
+{
+    return uint32_t(std::min(r, 1.0f) * 255.0f + 0.5f) | uint32_t(std::min(g, 1.0f) * 255.0f + 0.5f) << 8 |
+           uint32_t(std::min(b, 1.0f) * 255.0f + 0.5f) << 16;
+}
+
+// Light 0's ambient plus its diffuse term, with the light at (10, 20, 10)
+// taken as directional this close to the board
+float shade(Face face)
+{
+    static const float NDOTL[4] = {0.8165f, 0.4082f, 0.4082f, 0.0f};
+    return 0.4f + 0.7f * NDOTL[face];
+}
+
+uint32_t litColor(float r, float g, float b, Face face)
+{
+    float s = shade(face);
+    return rgb(r * s, g * s, b * s);
+}
+
+const uint32_t BACKGROUND = rgb(0.1f, 0.1f, 0.1f);
+const uint32_t GROUND_COLOR = litColor(0.35f, 0.55f, 0.25f, FACE_TOP);
+const uint32_t WALL_COLORS[4] = {litColor(0.55f, 0.45f, 0.35f, FACE_TOP), litColor(0.55f, 0.45f, 0.35f, FACE_FRONT),
+                                 litColor(0.55f, 0.45f, 0.35f, FACE_RIGHT), litColor(0.55f, 0.45f, 0.35f, FACE_LEFT)};
+
+// drawScene() turns lighting off for the snake and apples: one colour per box
+const uint32_t SEGMENT_COLORS[4] = {rgb(0.2f, 0.65f, 0.2f), rgb(0.2f, 0.65f, 0.2f), rgb(0.2f, 0.65f, 0.2f),
+                                    rgb(0.2f, 0.65f, 0.2f)};
+const uint32_t HEAD_COLORS[4] = {rgb(0.1f, 0.45f, 0.1f), rgb(0.1f, 0.45f, 0.1f), rgb(0.1f, 0.45f, 0.1f),
+                                 rgb(0.1f, 0.45f, 0.1f)};
+const uint32_t APPLE_COLORS[4] = {rgb(0.8f, 0.1f, 0.1f), rgb(0.8f, 0.1f, 0.1f), rgb(0.8f, 0.1f, 0.1f),
+                                  rgb(0.8f, 0.1f, 0.1f)};
+} // namespace
+
+PixelRenderer::PixelRenderer(const uint8_t *walls, int boardWidth, int boardHeight, int frameSize)
+    : width(boardWidth), height(boardHeight), size(frameSize), boxes(size_t(boardWidth) * boardHeight * BOX_KINDS),
+      base(size_t(frameSize) * frameSize * 3)
+{
+    // gluLookAt: forward, side and up axes of the camera
+    float f[3] = {-EYE[0], -EYE[1], -EYE[2]};
+    float fl = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for (float &v : f)
+        v /= fl;
+    float s[3] = {-f[2], 0.0f, f[0]}; // f x (0, 1, 0)
+    float sl = std::sqrt(s[0] * s[0] + s[2] * s[2]);
+    s[0] /= sl;
+    s[2] /= sl;
+    float u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+    const float *rows[3] = {s, u, f};
+    for (int r = 0; r < 3; r++)
+    {
+        view[r * 4 + 0] = rows[r][0];
+        view[r * 4 + 1] = rows[r][1];
+        view[r * 4 + 2] = rows[r][2];
+        view[r * 4 + 3] = -(rows[r][0] * EYE[0] + rows[r][1] * EYE[1] + rows[r][2] * EYE[2]);
+    }
+    focal = 0.5f * float(size) / std::tan(FOV_Y * 0.5f * 3.14159265f / 180.0f);
+
+    int originX = width / 2, originZ = height / 2;
+    for (int z = 0; z < height; z++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            float wx = float(x - originX), wz = float(z - originZ);
+            const float half[BOX_KINDS] = {0.5f, SEGMENT_SIZE / 2, APPLE_SIZE / 2};
+            const float bottom[BOX_KINDS] = {0.0f, SEGMENT_Y - SEGMENT_SIZE / 2, 0.0f};
+            const float top[BOX_KINDS] = {WALL_HEIGHT, SEGMENT_Y + SEGMENT_SIZE / 2, APPLE_SIZE};
+            for (int k = 0; k < BOX_KINDS; k++)
+            {
+                Box &box = boxes[(size_t(z) * width + x) * BOX_KINDS + k];
+                const float cx[4] = {wx - half[k], wx + half[k], wx + half[k], wx - half[k]};
+                const float cz[4] = {wz - half[k], wz - half[k], wz + half[k], wz + half[k]};
+                for (int c = 0; c < 4; c++)
+                {
+                    box.p[c] = project(cx[c], bottom[k], cz[c]);
+                    box.p[c + 4] = project(cx[c], top[k], cz[c]);
+                }
+            }
+        }
+    }
+
+    float minX = float(-originX) - 0.5f, maxX = float(width - 1 - originX) + 0.5f;
+    float minZ = float(-originZ) - 0.5f, maxZ = float(height - 1 - originZ) + 0.5f;
+    Point ground[4] = {project(minX, 0.0f, minZ), project(maxX, 0.0f, minZ), project(maxX, 0.0f, maxZ),
+                       project(minX, 0.0f, maxZ)};
+
+    // Far rows first; in each row the outside columns before the middle
+    // one, since boxes nearer the camera's x cover those further out
+    order.reserve(size_t(width) * height);
+    for (int z = 0; z < height; z++)
+    {
+        for (int x = 0; x < originX; x++)
+            order.push_back(z * width + x);
+        for (int x = width - 1; x > originX; x--)
+            order.push_back(z * width + x);
+        order.push_back(z * width + originX);
+    }
+
+    for (int y = 0; y < size; y++)
+        fillSpan(&base[size_t(y) * size * 3], 0, size, BACKGROUND);
+    fillQuad(ground, GROUND_COLOR, base.data());
+    for (int cell : order)
+    {
+        if (walls[cell] == CELL_WALL)
+            drawBox(boxes[size_t(cell) * BOX_KINDS + BOX_WALL], sideFace(cell), WALL_COLORS, base.data());
+    }
+}
+
+int PixelRenderer::sideFace(int cell) const
+{
+    int x = cell % width, originX = width / 2;
+    return x < originX ? FACE_RIGHT : x > originX ? FACE_LEFT : -1;
+}
+
+PixelRenderer::Point PixelRenderer::project(float x, float y, float z) const
+{
+    float cx = view[0] * x + view[1] * y + view[2] * z + view[3];
+    float cy = view[4] * x + view[5] * y + view[6] * z + view[7];
+    float depth = view[8] * x + view[9] * y + view[10] * z + view[11];
+    Point p;
+    p.x = 0.5f * float(size) + focal * cx / depth;
+    p.y = 0.5f * float(size) - focal * cy / depth;
+    return p;
+}
+
+void PixelRenderer::render(const uint8_t *grid, int head, uint8_t *out) const
+{
+    std::memcpy(out, base.data(), base.size());
+
+    // Walls before the first snake or apple cell are already right in base
+    bool covered = false;
+    for (int cell : order)
+    {
+        uint8_t type = grid[cell];
+        if (type == CELL_EMPTY || (type == CELL_WALL && !covered))
+            continue;
+        covered = true;
+        int side = sideFace(cell);
+        const Box *cellBoxes = &boxes[size_t(cell) * BOX_KINDS];
+        if (type == CELL_WALL)
+            drawBox(cellBoxes[BOX_WALL], side, WALL_COLORS, out);
+        else if (type == CELL_BODY)
+            drawBox(cellBoxes[BOX_SEGMENT], side, cell == head ? HEAD_COLORS : SEGMENT_COLORS, out);
+        else if (type == CELL_APPLE)
+            drawBox(cellBoxes[BOX_APPLE], side, APPLE_COLORS, out);
+    }
+}
+
+void PixelRenderer::drawBox(const Box &box, int side, const uint32_t *colors, uint8_t *out) const
+{
+    // Only the faces turned to the camera: the top, the +z front, and the
+    // side facing the middle column. They never overlap on screen.
+    static const int FACES[4][4] = {{4, 5, 6, 7}, {3, 2, 6, 7}, {1, 2, 6, 5}, {0, 3, 7, 4}};
+    int faces[3] = {side, FACE_FRONT, FACE_TOP};
+    for (int face : faces)
+    {
+        if (face < 0)
+            continue;
+        Point q[4];
+        for (int c = 0; c < 4; c++)
+            q[c] = box.p[FACES[face][c]];
+        fillQuad(q, colors[face], out);
+    }
+}
+
+void PixelRenderer::fillQuad(const Point *q, uint32_t color, uint8_t *out) const
+{
+    float minY = std::min(std::min(q[0].y, q[1].y), std::min(q[2].y, q[3].y));
+    float maxY = std::max(std::max(q[0].y, q[1].y), std::max(q[2].y, q[3].y));
+    int y0 = std::max(0, int(std::ceil(minY - 0.5f)));
+    int y1 = std::min(size, int(std::ceil(maxY - 0.5f)));
+    for (int y = y0; y < y1; y++)
+    {
+        // Pixel centers inside the convex quad on this row
+        float yc = float(y) + 0.5f;
+        float left = 1e30f, right = -1e30f;
+        for (int e = 0; e < 4; e++)
+        {
+            const Point &a = q[e], &b = q[(e + 1) & 3];
+            if ((a.y <= yc) == (b.y <= yc))
+                continue;
+            float x = a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y);
+            left = std::min(left, x);
+            right = std::max(right, x);
+        }
+        int x0 = std::max(0, int(std::ceil(left - 0.5f)));
+        int x1 = std::min(size, int(std::ceil(right - 0.5f)));
+        if (x0 < x1)
+            fillSpan(out + size_t(y) * size * 3, x0, x1, color);
+    }
+}
+
+void PixelRenderer::fillSpan(uint8_t *row, int x0, int x1, uint32_t color) const
+{
+    uint8_t r = uint8_t(color), g = uint8_t(color >> 8), b = uint8_t(color >> 16);
+    uint8_t *p = row + x0 * 3;
+    int n = x1 - x0;
+#if defined(__SSE2__)
+    // Sixteen pixels are 48 bytes: three stores of one repeating pattern
+    if (n >= 16)
+    {
+        alignas(16) uint8_t pattern[48];
+        for (int i = 0; i < 48; i += 3)
+        {
+            pattern[i] = r;
+            pattern[i + 1] = g;
+            pattern[i + 2] = b;
+        }
+        __m128i v0 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern));
+        __m128i v1 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern + 16));
+        __m128i v2 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern + 32));
+        for (; n >= 16; n -= 16, p += 48)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v0);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 16), v1);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 32), v2);
+        }
+    }
+#endif
+    for (; n > 0; n--, p += 3)
+    {
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+}
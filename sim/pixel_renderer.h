@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "batch_env.h"
+#include "snake_sim.h"
+#include "work_stealing_pool.h"
+
+// Software renderer for small RGB frames of the game, for agents that
+// learn from pixels on machines with no GL context. It draws the same
+// scene as display()/drawScene() from the same camera (gluLookAt from
+// (0, 18, 22) at the origin, 45 degree field of view) as flat-shaded
+// boxes: walls, snake cubes, a darker head and red apples on the ground.
+//
+// Every object sits on its own grid cell and the camera looks down from
+// above the middle of the near edge, so drawing cells far row to near row,
+// outside columns first, is a correct painter's order with no depth
+// buffer. Each box is at most three visible faces, filled span by span
+// with SSE2 stores. Box corners for every cell are projected once, and
+// the background, ground and walls are drawn once into a base frame that
+// each render starts from; only walls that come after a snake or apple
+// cell in drawing order are drawn again.
+class PixelRenderer
+{
+public:
+    // walls is any grid of the board (boardWidth x boardHeight CellType
+    // bytes); only its wall cells are used. Frames are frameSize square.
+    PixelRenderer(const uint8_t *walls, int boardWidth, int boardHeight, int frameSize);
+
+    template <class Rules>
+    static PixelRenderer forRules(int frameSize)
+    {
+        return PixelRenderer(SnakeGame<Rules>::wallGrid().data(), Rules::WIDTH, Rules::HEIGHT, frameSize);
+    }
+
+    int frameSize() const { return size; }
+    int frameBytes() const { return size * size * 3; }
+
+    // Draws one board (grid bytes as CellType, head as a cell index) into
+    // frameBytes() of RGB, rows top to bottom
+    void render(const uint8_t *grid, int head, uint8_t *rgb) const;
+
+    template <class Rules>
+    void render(const SnakeGame<Rules> &game, uint8_t *rgb) const
+    {
+        const Segment &h = game.snake().head();
+        render(game.cells().data(), SnakeGame<Rules>::Grid::index(h.x, h.z), rgb);
+    }
+
+private:
+    struct Point
+    {
+        float x, y;
+    };
+
+    // Projected corners of one box: bottom four then top four, in the
+    // order (-x,-z) (+x,-z) (+x,+z) (-x,+z)
+    struct Box
+    {
+        Point p[8];
+    };
+
+    enum BoxKind
+    {
+        BOX_WALL,
+        BOX_SEGMENT,
+        BOX_APPLE,
+        BOX_KINDS
+    };
+
+    Point project(float x, float y, float z) const;
+    int sideFace(int cell) const;
+    void drawBox(const Box &box, int side, const uint32_t *colors, uint8_t *rgb) const;
+    void fillQuad(const Point *q, uint32_t color, uint8_t *rgb) const;
+    void fillSpan(uint8_t *row, int x0, int x1, uint32_t color) const;
+
+    int width, height, size;
+    float view[12];           // World to camera, 3x4
+    float focal;              // Projection scale in pixels
+    std::vector<Box> boxes;   // BOX_KINDS per cell
+    std::vector<int> order;   // Cells in painter's order
+    std::vector<uint8_t> base; // Background, ground and walls
+};
+
+// Renders count games across the pool into frames (frameBytes() each)
+template <class Rules>
+void renderBatch(WorkStealingPool &pool, const PixelRenderer &renderer,
+                 const SnakeGame<Rules> *const *games, int count, uint8_t *frames)
+{
+    auto draw = [&](uint64_t i, unsigned)
+    { renderer.render(*games[i], frames + i * size_t(renderer.frameBytes())); };
+    pool.run(uint64_t(count), draw);
+}
+
+template <class Rules>
+void renderBatch(WorkStealingPool &pool, const PixelRenderer &renderer, const BatchEnv<Rules> &env,
+                 uint8_t *frames)
+{
+    typedef typename BatchEnv<Rules>::Grid Grid;
+    auto draw = [&](uint64_t i, unsigned)
+    {
+        int head = Grid::index(env.headXs()[i], env.headZs()[i]);
+        renderer.render(env.grid(int(i)).data(), head, frames + i * size_t(renderer.frameBytes()));
+    };
+    pool.run(uint64_t(env.size()), draw);
+}
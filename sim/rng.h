@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+
+// xoshiro256** generator, one per game instance. 32 bytes of state, no
+// locking and no libc calls, so many games can run side by side and the
+// same seed always replays the same game.
+class Rng
+{
+public:
+    explicit Rng(uint64_t seed = 0) { reseed(seed); }
+
+    // Expands the seed with splitmix64 so nearby seeds give unrelated streams
+    void reseed(uint64_t seed)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+
+    // Generator for parallel worker `stream`: same seed, advanced by
+    // `stream` jumps of 2^128 draws, so the streams never overlap
+    static Rng forStream(uint64_t seed, unsigned stream)
+    {
+        Rng rng(seed);
+        for (unsigned i = 0; i < stream; i++)
+            rng.jump();
+        return rng;
+    }
+
+    uint64_t next()
+    {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform value in [0, n) by multiply-shift instead of a modulo
+    uint32_t below(uint32_t n)
+    {
+        return uint32_t(((next() >> 32) * uint64_t(n)) >> 32);
+    }
+
+    // Advances the state by 2^128 draws
+    void jump()
+    {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+                                        0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; i++)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (JUMP[i] & (uint64_t(1) << b))
+                {
+                    for (int k = 0; k < 4; k++)
+                        t[k] ^= s[k];
+                }
+                next();
+            }
+        }
+        for (int k = 0; k < 4; k++)
+            s[k] = t[k];
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t s[4];
+};
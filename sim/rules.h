@@ -0,0 +1,68 @@
+#pragma once
+
+// Rule sets for SnakeGame. Each is a set of compile-time constants, so a
+// game instantiated with one folds board bounds into constants and masks
+// and drops the branches for features it does not use.
+//
+//   WIDTH, HEIGHT   Grid size in cells, boundary walls included
+//   WRAP            Edges wrap around instead of being walled off
+//   GROWTH          Segments added per apple eaten
+//   APPLES          Apples kept on the board at once
+//   SPAWN_MARGIN    Cells along the edge where apples never spawn
+//   INTERIOR_WALLS  Add the two classic interior walls
+
+// The original game: 21x21 walled arena, one apple, the two inner walls
+struct ClassicRules
+{
+    static constexpr int WIDTH = 21;
+    static constexpr int HEIGHT = 21;
+    static constexpr bool WRAP = false;
+    static constexpr int GROWTH = 1;
+    static constexpr int APPLES = 1;
+    static constexpr int SPAWN_MARGIN = 2;
+    static constexpr bool INTERIOR_WALLS = true;
+};
+
+// Open 16x16 torus, no walls at all
+struct WrapRules
+{
+    static constexpr int WIDTH = 16;
+    static constexpr int HEIGHT = 16;
+    static constexpr bool WRAP = true;
+    static constexpr int GROWTH = 1;
+    static constexpr int APPLES = 1;
+    static constexpr int SPAWN_MARGIN = 0;
+    static constexpr bool INTERIOR_WALLS = false;
+};
+
+// Large walled arena with apples raining everywhere
+struct AppleRainRules
+{
+    static constexpr int WIDTH = 64;
+    static constexpr int HEIGHT = 64;
+    static constexpr bool WRAP = false;
+    static constexpr int GROWTH = 1;
+    static constexpr int APPLES = 1024;
+    static constexpr int SPAWN_MARGIN = 1;
+    static constexpr bool INTERIOR_WALLS = false;
+};
+
+// The same knobs chosen at run time, for code that cannot pick a rule set
+// at compile time (see createGame())
+struct RuleConfig
+{
+    int width;
+    int height;
+    bool wrap;
+    int growth;
+    int apples;
+    int spawnMargin;
+    bool interiorWalls;
+};
+
+template <class Rules>
+constexpr RuleConfig ruleConfig()
+{
+    return {Rules::WIDTH, Rules::HEIGHT, Rules::WRAP, Rules::GROWTH,
+            Rules::APPLES, Rules::SPAWN_MARGIN, Rules::INTERIOR_WALLS};
+}
@@ -0,0 +1,171 @@
+#include "shared_states.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+const uint32_t MAGIC = 0x534e4b31; // "SNK1"
+const int READ_ATTEMPTS = 64;
+const size_t HEADER_BYTES = 64; // Header, padded so slots start on a cache line
+
+// shm_open() wants a single leading slash
+void shmPath(const char *name, char *out, size_t size)
+{
+    snprintf(out, size, "/%s", name[0] == '/' ? name + 1 : name);
+}
+} // namespace
+
+SharedStates::SharedStates() : header(nullptr), mappedBytes(0), slotStride(0), owner(false)
+{
+    shmName[0] = 0;
+}
+
+SharedStates::~SharedStates()
+{
+    if (header)
+        munmap(header, mappedBytes);
+    if (owner)
+        shm_unlink(shmName);
+}
+
+bool SharedStates::create(const char *name, int slots, size_t stateBytes, int width, int height)
+{
+    static_assert(sizeof(Header) <= HEADER_BYTES, "header must fit before the first slot");
+    if (header || slots < 1)
+        return false;
+    shmPath(name, shmName, sizeof(shmName));
+    shm_unlink(shmName);
+    int fd = shm_open(shmName, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    size_t stride = sizeof(Slot) + ((stateBytes + 63) & ~size_t(63));
+    size_t bytes = HEADER_BYTES + size_t(slots) * stride;
+    if (ftruncate(fd, off_t(bytes)) != 0 || !map(fd, bytes, true))
+    {
+        close(fd);
+        shm_unlink(shmName);
+        return false;
+    }
+    close(fd);
+    owner = true;
+
+    // Fresh pages are zero: every sequence starts even with nothing in it
+    header->slots = uint32_t(slots);
+    header->stateBytes = stateBytes;
+    header->width = width;
+    header->height = height;
+    slotStride = stride;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MAGIC;
+    return true;
+}
+
+bool SharedStates::open(const char *name)
+{
+    if (header)
+        return false;
+    shmPath(name, shmName, sizeof(shmName));
+    int fd = shm_open(shmName, O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0 && size_t(info.st_size) >= HEADER_BYTES && map(fd, size_t(info.st_size), false);
+    close(fd);
+    if (!ok)
+        return false;
+
+    slotStride = sizeof(Slot) + ((header->stateBytes + 63) & ~uint64_t(63));
+    if (header->magic != MAGIC || HEADER_BYTES + header->slots * slotStride > mappedBytes)
+    {
+        munmap(header, mappedBytes);
+        header = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool SharedStates::map(int fd, size_t bytes, bool writable)
+{
+    void *p = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        return false;
+    header = static_cast<Header *>(p);
+    mappedBytes = bytes;
+    return true;
+}
+
+int SharedStates::slots() const
+{
+    return header ? int(header->slots) : 0;
+}
+
+size_t SharedStates::stateBytes() const
+{
+    return header ? size_t(header->stateBytes) : 0;
+}
+
+int SharedStates::width() const
+{
+    return header ? header->width : 0;
+}
+
+int SharedStates::height() const
+{
+    return header ? header->height : 0;
+}
+
+SharedStates::Slot *SharedStates::slotAt(int slot) const
+{
+    return reinterpret_cast<Slot *>(reinterpret_cast<uint8_t *>(header) + HEADER_BYTES + size_t(slot) * slotStride);
+}
+
+void SharedStates::publish(int slot, int32_t gameId, const void *state)
+{
+    memcpy(beginPublish(slot, gameId), state, size_t(header->stateBytes));
+    endPublish(slot);
+}
+
+// Makes the sequence odd and returns where the state bytes go
+uint8_t *SharedStates::beginPublish(int slot, int32_t gameId)
+{
+    Slot *s = slotAt(slot);
+    uint32_t seq = s->sequence.load(std::memory_order_relaxed);
+    s->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s->gameId = gameId;
+    return reinterpret_cast<uint8_t *>(s) + sizeof(Slot);
+}
+
+void SharedStates::endPublish(int slot)
+{
+    Slot *s = slotAt(slot);
+    s->sequence.store(s->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool SharedStates::read(int slot, int32_t &gameId, void *state) const
+{
+    if (slot < 0 || slot >= slots())
+        return false;
+    const Slot *s = slotAt(slot);
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++)
+    {
+        uint32_t before = s->sequence.load(std::memory_order_acquire);
+        if (before == 0)
+            return false; // Never published
+        if (before & 1)
+            continue;
+        gameId = s->gameId;
+        memcpy(state, reinterpret_cast<const uint8_t *>(s) + sizeof(Slot), size_t(header->stateBytes));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s->sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
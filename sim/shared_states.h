@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "snake_sim.h"
+
+// Game states published by one process into a named POSIX shared-memory
+// region for another to watch, e.g. the GLUT viewer (snake3d --view)
+// attached to a training job. The region holds a fixed number of slots,
+// each a seqlock around one game's SnakeGame::Parts: the writer bumps the
+// slot's sequence to odd, copies the state in and bumps it back to even,
+// so it never waits for a reader. A reader copies the state out and keeps
+// it only if the sequence was even and unchanged across the copy; the
+// reader, not the writer, then rebuilds the rest of the game from it.
+class SharedStates
+{
+public:
+    SharedStates();
+    ~SharedStates(); // Unmaps, and removes the region if this side created it
+
+    SharedStates(const SharedStates &) = delete;
+    SharedStates &operator=(const SharedStates &) = delete;
+
+    // Writer: makes a new region (replacing any of the same name) with
+    // slots of stateBytes each, for a width x height board. Returns false
+    // if it can't be created.
+    bool create(const char *name, int slots, size_t stateBytes, int width, int height);
+
+    template <class Rules>
+    bool create(const char *name, int slots)
+    {
+        return create(name, slots, sizeof(typename SnakeGame<Rules>::Parts), Rules::WIDTH, Rules::HEIGHT);
+    }
+
+    // Reader: maps an existing region. Returns false if there is none or
+    // it isn't a region of this format.
+    bool open(const char *name);
+
+    bool valid() const { return header != nullptr; }
+    int slots() const;
+    size_t stateBytes() const;
+    int width() const;
+    int height() const;
+
+    // True if the slots hold SnakeGame<Rules> states (as Parts)
+    template <class Rules>
+    bool holds() const
+    {
+        return stateBytes() == sizeof(typename SnakeGame<Rules>::Parts) && width() == Rules::WIDTH &&
+               height() == Rules::HEIGHT;
+    }
+
+    // Writer: copies stateBytes() of state into slot, tagged with the id
+    // of the game it came from
+    void publish(int slot, int32_t gameId, const void *state);
+
+    // Writer: same, but fill(state) writes the stateBytes() straight into
+    // the slot, e.g. BatchEnv::saveParts() with no copy in between
+    template <class Fill>
+    void publishWith(int slot, int32_t gameId, Fill &&fill)
+    {
+        fill(beginPublish(slot, gameId));
+        endPublish(slot);
+    }
+
+    // Writer: a game's Parts, saved straight into the slot
+    template <class Rules>
+    void publish(int slot, int32_t gameId, const SnakeGame<Rules> &game)
+    {
+        typedef typename SnakeGame<Rules>::Parts Parts;
+        publishWith(slot, gameId, [&](void *state) { game.save(*static_cast<Parts *>(state)); });
+    }
+
+    // Reader: copies slot's latest state out. Returns false if nothing has
+    // been published there yet, or the writer kept overwriting it while
+    // we copied. The game overload also returns false, leaving the game
+    // alone, if the state doesn't check out (SnakeGame::restore()).
+    bool read(int slot, int32_t &gameId, void *state) const;
+
+    template <class Rules>
+    bool read(int slot, int32_t &gameId, SnakeGame<Rules> &game) const
+    {
+        typename SnakeGame<Rules>::Parts parts;
+        if (!holds<Rules>() || !read(slot, gameId, static_cast<void *>(&parts)))
+            return false;
+        return game.restore(parts);
+    }
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t slots;
+        uint64_t stateBytes;
+        int32_t width, height;
+    };
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint32_t> sequence; // Odd while a publish is in progress
+        int32_t gameId;
+        // State bytes follow, padded to a multiple of 64
+    };
+
+    Slot *slotAt(int slot) const;
+    uint8_t *beginPublish(int slot, int32_t gameId);
+    void endPublish(int slot);
+    bool map(int fd, size_t bytes, bool writable);
+
+    Header *header;
+    size_t mappedBytes;
+    size_t slotStride;
+    char shmName[256];
+    bool owner;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// Plain data shared by the simulation and its front-ends.
+
+// Grid cell on the ground plane, one unit per cell
+struct Cell
+{
+    int16_t x, z;
+};
+
+typedef Cell Segment;
+
+struct Apple
+{
+    int16_t x, z;
+};
+
+struct Wall
+{
+    float x, z; // Center position
+    float w, d; // Width and depth
+};
+
+enum GameState
+{
+    PLAYING,
+    GAME_OVER
+};
+
+// What ended a round
+enum DeathCause
+{
+    DEATH_NONE, // Still playing
+    DEATH_WALL,
+    DEATH_SELF
+};
+
+enum Direction
+{
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT
+};
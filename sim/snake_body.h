@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+#include "sim_types.h"
+
+// Snake body stored as a ring buffer, head first. Moving the snake is one
+// pushHead() plus one popTail(), so a tick costs the same at any length.
+// CAPACITY is a power of two no smaller than the board, so the ring can
+// hold the longest possible snake and never has to grow.
+template <size_t CAPACITY>
+class SnakeBody
+{
+public:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+    SnakeBody() : headIdx(0), count(0) {}
+
+    void clear()
+    {
+        headIdx = 0;
+        count = 0;
+    }
+
+    void pushHead(Segment s)
+    {
+        headIdx = (headIdx - 1) & MASK;
+        ring[headIdx] = s;
+        count++;
+    }
+
+    void popTail()
+    {
+        if (count > 0)
+            count--;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    static constexpr size_t capacity() { return CAPACITY; }
+
+    // i = 0 is the head, size() - 1 the tail
+    const Segment &operator[](size_t i) const { return ring[(headIdx + i) & MASK]; }
+    const Segment &head() const { return ring[headIdx]; }
+    const Segment &tail() const { return ring[(headIdx + count - 1) & MASK]; }
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    Segment ring[CAPACITY];
+    size_t headIdx;
+    size_t count;
+};
+
+// Smallest power of two >= n, for sizing rings at compile time
+constexpr size_t ringCapacity(size_t n, size_t p = 1)
+{
+    return p >= n ? p : ringCapacity(n, p * 2);
+}
@@ -0,0 +1,300 @@
+#include "snake_c.h"
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "batch_env.h"
+#include "observation.h"
+#include "pixel_renderer.h"
+#include "shared_states.h"
+
+// Opaque handle behind the C API: one BatchEnv of a fixed rule set
+struct snake_env
+{
+    virtual ~snake_env() {}
+    virtual int numEnvs() const = 0;
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+    virtual int observationSize() const = 0;
+    virtual void setObservation(int mode) = 0;
+    virtual void setWindow(int k) = 0;
+    virtual void setFrameSize(int size) = 0;
+    virtual int share(const char *name, const int32_t *ids, int count) = 0;
+    virtual void bind(uint8_t *obs, float *rewards, uint8_t *dones, const uint8_t *actions,
+                      int32_t *finalScores) = 0;
+    virtual void reset() = 0;
+    virtual void step() = 0;
+};
+
+namespace
+{
+
+template <class Rules>
+class EnvKernel : public snake_env
+{
+public:
+    EnvKernel(int count, uint64_t seed)
+        : env(count, seed), mode(SNAKE_OBS_GRID),
+          window(11, Rules::WIDTH, Rules::HEIGHT, Rules::WRAP), frameSize(84),
+          observations(nullptr), actions(nullptr)
+    {
+    }
+
+    int numEnvs() const { return env.size(); }
+    int width() const { return Rules::WIDTH; }
+    int height() const { return Rules::HEIGHT; }
+
+    int observationSize() const
+    {
+        switch (mode)
+        {
+        case SNAKE_OBS_PLANES:
+            return 4 * Grid::CELLS;
+        case SNAKE_OBS_PLANES_PACKED:
+            return 4 * packedPlaneBytes(Grid::CELLS);
+        case SNAKE_OBS_WINDOW:
+            return window.size();
+        case SNAKE_OBS_PIXELS:
+            return frameSize * frameSize * 3;
+        }
+        return Grid::CELLS;
+    }
+
+    void setObservation(int m)
+    {
+        std::vector<PlaneEncoder<Rules>> fresh(size_t(env.size()), PlaneEncoder<Rules>(m == SNAKE_OBS_PLANES_PACKED));
+        encoders.swap(fresh);
+        mode = m;
+    }
+
+    void setWindow(int k) { window = EgoWindow(k, Rules::WIDTH, Rules::HEIGHT, Rules::WRAP); }
+
+    void setFrameSize(int size)
+    {
+        frameSize = size;
+        renderer.reset();
+    }
+
+    int share(const char *name, const int32_t *ids, int count)
+    {
+        shared.reset();
+        sharedIds.clear();
+        if (count <= 0)
+            return 0;
+        // snake3d --view only draws classic games
+        if (!std::is_same<Rules, ClassicRules>::value)
+            return -1;
+        for (int k = 0; k < count; k++)
+        {
+            if (ids[k] < 0 || ids[k] >= env.size())
+                return -1;
+        }
+        shared.reset(new SharedStates());
+        if (!shared->create<Rules>(name, count))
+        {
+            shared.reset();
+            return -1;
+        }
+        sharedIds.assign(ids, ids + count);
+        publish();
+        return 0;
+    }
+
+    void bind(uint8_t *obs, float *rewards, uint8_t *dones, const uint8_t *acts, int32_t *finalScores)
+    {
+        observations = obs;
+        actions = acts;
+        env.bindOutputs(rewards, dones, finalScores);
+    }
+
+    void reset()
+    {
+        env.reset();
+        observe();
+        publish();
+    }
+
+    void step()
+    {
+        if (actions)
+            env.step(actions);
+        observe();
+        publish();
+    }
+
+private:
+    typedef typename BatchEnv<Rules>::Grid Grid;
+
+    // The grid already holds walls, body and apples; the raw layout only
+    // needs the head marked on top. The plane layouts are kept up to date
+    // in place from each game's change log.
+    void observe()
+    {
+        if (!observations)
+            return;
+        if (mode == SNAKE_OBS_PIXELS)
+        {
+            // Threads and projected geometry are set up on first use
+            if (!pool)
+                pool.reset(new WorkStealingPool());
+            if (!renderer)
+                renderer.reset(new PixelRenderer(PixelRenderer::forRules<Rules>(frameSize)));
+            renderBatch(*pool, *renderer, env, observations);
+            return;
+        }
+        size_t stride = size_t(observationSize());
+        for (int i = 0; i < env.size(); i++)
+        {
+            uint8_t *out = observations + size_t(i) * stride;
+            const uint8_t *grid = env.grid(i).data();
+            int head = Grid::index(env.headXs()[i], env.headZs()[i]);
+            switch (mode)
+            {
+            case SNAKE_OBS_PLANES:
+            case SNAKE_OBS_PLANES_PACKED:
+                encoders[i].encode(grid, head, env.changes(i), env.episode(i), env.tick(i), out);
+                break;
+            case SNAKE_OBS_WINDOW:
+                window.extract(grid, env.headXs()[i], env.headZs()[i],
+                               Direction(env.directions()[i]), out);
+                break;
+            default:
+                memcpy(out, grid, Grid::CELLS);
+                out[head] = SNAKE_CELL_HEAD;
+                break;
+            }
+        }
+    }
+
+    void publish()
+    {
+        for (size_t k = 0; k < sharedIds.size(); k++)
+        {
+            int32_t id = sharedIds[k];
+            shared->publishWith(int(k), id, [&](uint8_t *state) { env.saveParts(id, state); });
+        }
+    }
+
+    BatchEnv<Rules> env;
+    int mode;
+    std::vector<PlaneEncoder<Rules>> encoders; // Per game, in the plane modes
+    EgoWindow window;
+    int frameSize;
+    std::unique_ptr<WorkStealingPool> pool;
+    std::unique_ptr<PixelRenderer> renderer;
+    std::unique_ptr<SharedStates> shared;
+    std::vector<int32_t> sharedIds;
+    uint8_t *observations;
+    const uint8_t *actions;
+};
+
+// Runs fn at the ABI boundary: nothing thrown (bad_alloc from a BatchEnv,
+// SharedStates or worker threads) may unwind into a C caller
+template <class Fn>
+int guarded(Fn &&fn)
+{
+    try
+    {
+        return fn();
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+snake_env *snake_env_create(int rules, int num_envs, uint64_t seed)
+{
+    if (num_envs < 1)
+        return nullptr;
+    try
+    {
+        switch (rules)
+        {
+        case SNAKE_RULES_CLASSIC:
+            return new EnvKernel<ClassicRules>(num_envs, seed);
+        case SNAKE_RULES_WRAP:
+            return new EnvKernel<WrapRules>(num_envs, seed);
+        case SNAKE_RULES_APPLE_RAIN:
+            return new EnvKernel<AppleRainRules>(num_envs, seed);
+        }
+    }
+    catch (...)
+    {
+    }
+    return nullptr;
+}
+
+void snake_env_destroy(snake_env *env)
+{
+    delete env;
+}
+
+int snake_env_num_envs(const snake_env *env)
+{
+    return env->numEnvs();
+}
+
+int snake_env_width(const snake_env *env)
+{
+    return env->width();
+}
+
+int snake_env_height(const snake_env *env)
+{
+    return env->height();
+}
+
+int snake_env_set_observation(snake_env *env, int mode)
+{
+    if (mode < SNAKE_OBS_GRID || mode > SNAKE_OBS_PIXELS)
+        return -1;
+    return guarded([&] { env->setObservation(mode); return 0; });
+}
+
+int snake_env_set_window(snake_env *env, int k)
+{
+    if (k < 1)
+        return -1;
+    return guarded([&] { env->setWindow(k); return 0; });
+}
+
+void snake_env_set_frame_size(snake_env *env, int size)
+{
+    if (size > 0)
+        env->setFrameSize(size);
+}
+
+int snake_env_observation_size(const snake_env *env)
+{
+    return env->observationSize();
+}
+
+int snake_env_share(snake_env *env, const char *name, const int32_t *ids, int count)
+{
+    return guarded([&] { return env->share(name, ids, count); });
+}
+
+void snake_env_bind(snake_env *env, uint8_t *observations, float *rewards, uint8_t *dones,
+                    const uint8_t *actions, int32_t *final_scores)
+{
+    env->bind(observations, rewards, dones, actions, final_scores);
+}
+
+int snake_env_reset(snake_env *env)
+{
+    return guarded([&] { env->reset(); return 0; });
+}
+
+int snake_env_step(snake_env *env)
+{
+    return guarded([&] { env->step(); return 0; });
+}
+
+} // extern "C"
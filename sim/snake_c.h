@@ -0,0 +1,135 @@
+#ifndef SNAKE_C_H
+#define SNAKE_C_H
+
+/*
+ * Plain C interface to the batched game rules, exported from
+ * libsnake_sim.so for ctypes and other FFI callers.
+ *
+ * The caller allocates the observation, reward, done and action arrays
+ * once and binds them to the env. Every reset/step then reads actions from
+ * and writes results straight into those arrays, so a step makes no
+ * per-step copies or conversions on either side:
+ *
+ *     snake_env *env = snake_env_create(SNAKE_RULES_CLASSIC, 256, 1);
+ *     snake_env_bind(env, obs, rewards, dones, actions, NULL);
+ *     snake_env_reset(env);
+ *     for (;;) { fill actions...; snake_env_step(env); }
+ *
+ * By default observations are width * height bytes per env, row by row
+ * (z major), one SNAKE_CELL_* value per cell. snake_env_set_observation()
+ * switches to stacked wall/body/head/apple planes, to an egocentric
+ * window around the head (see sim/observation.h) or to RGB frames of the
+ * 3D view (see sim/pixel_renderer.h).
+ *
+ * No C++ exception crosses this interface: calls that can run out of
+ * memory report it as NULL or -1, as documented on each.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Rule sets (see sim/rules.h) */
+enum
+{
+    SNAKE_RULES_CLASSIC = 0,
+    SNAKE_RULES_WRAP = 1,
+    SNAKE_RULES_APPLE_RAIN = 2
+};
+
+/* Cell values in observations */
+enum
+{
+    SNAKE_CELL_EMPTY = 0,
+    SNAKE_CELL_WALL = 1,
+    SNAKE_CELL_BODY = 2,
+    SNAKE_CELL_APPLE = 3,
+    SNAKE_CELL_HEAD = 4
+};
+
+/* Observation layouts */
+enum
+{
+    SNAKE_OBS_GRID = 0,         /* one SNAKE_CELL_* byte per cell */
+    SNAKE_OBS_PLANES = 1,       /* 4 planes, one 0/1 byte per cell */
+    SNAKE_OBS_PLANES_PACKED = 2, /* 4 planes, one bit per cell */
+    SNAKE_OBS_WINDOW = 3,        /* K x K cell codes around the head, facing up */
+    SNAKE_OBS_PIXELS = 4         /* S x S x 3 RGB bytes of the game camera's view */
+};
+
+/* Actions: 0 up, 1 down, 2 left, 3 right */
+
+typedef struct snake_env snake_env;
+
+/* Returns NULL for an unknown rule set, num_envs < 1 or out of memory */
+snake_env *snake_env_create(int rules, int num_envs, uint64_t seed);
+void snake_env_destroy(snake_env *env);
+
+int snake_env_num_envs(const snake_env *env);
+int snake_env_width(const snake_env *env);
+int snake_env_height(const snake_env *env);
+
+/* Picks the observation layout; returns 0, or -1 for an unknown mode or
+ * out of memory (the layout is then unchanged). Changes
+ * observation_size, so call it before allocating and binding. */
+int snake_env_set_observation(snake_env *env, int mode);
+
+/* Window size for SNAKE_OBS_WINDOW (default 11, rounded up to odd).
+ * Returns 0, or -1 for k < 1 or out of memory (the size is unchanged). */
+int snake_env_set_window(snake_env *env, int k);
+
+/* Frame size for SNAKE_OBS_PIXELS (default 84). Frames of all envs are
+ * rendered in parallel on a thread per core. */
+void snake_env_set_frame_size(snake_env *env, int size);
+
+/* Bytes of observation per env for the current layout */
+int snake_env_observation_size(const snake_env *env);
+
+/*
+ * Binds caller-owned arrays, each num_envs long (observations is
+ * num_envs * observation_size bytes). final_scores may be NULL; where
+ * dones[i] is set it receives the score of the game that just ended.
+ * The arrays must stay valid until rebound or the env is destroyed. In
+ * the plane layouts a step only rewrites the cells that changed, so the
+ * caller must not write into observations.
+ */
+void snake_env_bind(snake_env *env, uint8_t *observations, float *rewards, uint8_t *dones,
+                    const uint8_t *actions, int32_t *final_scores);
+
+/*
+ * Publishes the games listed in ids[0..count) into the shared-memory
+ * region name after every reset/step, slot k holding game ids[k], for
+ * `snake3d --view name` to watch. Publishing never waits for the viewer.
+ * The viewer only draws SNAKE_RULES_CLASSIC games, so other rule sets
+ * can't be shared. Returns 0, or -1 for other rules, an id out of range,
+ * a region that can't be created or out of memory; count 0 stops
+ * publishing.
+ */
+int snake_env_share(snake_env *env, const char *name, const int32_t *ids, int count);
+
+/* Starts a new round in every env and writes observations. Returns 0, or
+ * -1 if observations couldn't be written (out of memory setting up
+ * SNAKE_OBS_PIXELS rendering on first use). */
+int snake_env_reset(snake_env *env);
+
+/* Steps every env with the bound actions; finished envs reset themselves.
+ * Returns 0, or -1 as snake_env_reset() does. */
+int snake_env_step(snake_env *env);
+
+/*
+ * Policies loaded by snake_eval --policy-lib: a shared library exporting
+ *
+ *     int snake_policy_act(const uint8_t *cells, int width, int height, int direction);
+ *
+ * cells is one board in the SNAKE_OBS_GRID layout, direction the current
+ * heading; it returns an action. It is called from several threads at once.
+ */
+typedef int (*snake_policy_act_fn)(const uint8_t *cells, int width, int height, int direction);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,69 @@
+#include "snake_sim.h"
+
+// Rule sets compiled into the library; createGame() dispatches to these
+template class SnakeGame<ClassicRules>;
+template class SnakeGame<WrapRules>;
+template class SnakeGame<AppleRainRules>;
+
+namespace
+{
+
+template <class Rules>
+class GameKernel : public AnySnakeGame
+{
+public:
+    explicit GameKernel(uint64_t seed) : game(seed) {}
+
+    RuleConfig config() const { return ruleConfig<Rules>(); }
+    void reset() { game.reset(); }
+    GameState step(Direction dir) { return game.step(dir); }
+
+    int play(const Direction *dirs, int count)
+    {
+        int rounds = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (game.step(dirs[i]) == GAME_OVER)
+            {
+                game.reset();
+                rounds++;
+            }
+        }
+        return rounds;
+    }
+
+    GameState state() const { return game.state(); }
+    int score() const { return game.score(); }
+    int highScore() const { return game.highScore(); }
+    int length() const { return int(game.snake().size()); }
+
+private:
+    SnakeGame<Rules> game;
+};
+
+bool sameConfig(const RuleConfig &a, const RuleConfig &b)
+{
+    return a.width == b.width && a.height == b.height && a.wrap == b.wrap &&
+           a.growth == b.growth && a.apples == b.apples &&
+           a.spawnMargin == b.spawnMargin && a.interiorWalls == b.interiorWalls;
+}
+
+template <class Rules>
+bool tryCreate(const RuleConfig &config, uint64_t seed, std::unique_ptr<AnySnakeGame> &out)
+{
+    if (out || !sameConfig(config, ruleConfig<Rules>()))
+        return false;
+    out.reset(new GameKernel<Rules>(seed));
+    return true;
+}
+
+} // namespace
+
+std::unique_ptr<AnySnakeGame> createGame(const RuleConfig &config, uint64_t seed)
+{
+    std::unique_ptr<AnySnakeGame> game;
+    tryCreate<ClassicRules>(config, seed, game);
+    tryCreate<WrapRules>(config, seed, game);
+    tryCreate<AppleRainRules>(config, seed, game);
+    return game;
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "apple_store.h"
+#include "free_cell_set.h"
+#include "occupancy_grid.h"
+#include "rng.h"
+#include "rules.h"
+#include "sim_types.h"
+#include "snake_body.h"
+#include "zobrist.h"
+
+template <class Rules>
+struct GameSnapshot;
+
+// Headless game rules for Snake 3D. Nothing in here touches GL/GLUT, so the
+// simulation can be stepped as fast as the CPU allows; main.cpp only drives
+// it from the GLUT timer and draws whatever state it exposes.
+//
+// The game is a template over a rule set (see rules.h). Cells are in local
+// grid coordinates, 0 to WIDTH - 1; worldX()/worldZ() give the position
+// on the ground plane, with the middle of the board at the origin.
+template <class Rules>
+class SnakeGame
+{
+public:
+    static constexpr int WIDTH = Rules::WIDTH;
+    static constexpr int HEIGHT = Rules::HEIGHT;
+    static constexpr int CELLS = WIDTH * HEIGHT;
+    static constexpr int ORIGIN_X = WIDTH / 2; // Local cell at world x = 0
+    static constexpr int ORIGIN_Z = HEIGHT / 2;
+
+    typedef OccupancyGrid<WIDTH, HEIGHT> Grid;
+    typedef SnakeBody<ringCapacity(CELLS + 1)> Body;
+    typedef AppleStore<Rules::APPLES, WIDTH, HEIGHT> Apples;
+    typedef FreeCellSet<CELLS> FreeCells;
+
+    typedef GameSnapshot<Rules> Snapshot;
+
+    explicit SnakeGame(uint64_t seed = 0);
+
+    // Copies the whole game into / back out of a snapshot with one memcpy
+    void save(Snapshot &snapshot) const;
+    void restore(const Snapshot &snapshot);
+
+    // Just the state that can't be worked out from the rest, in a fixed
+    // layout: the form games are published in (see SharedStates), which a
+    // game kept elsewhere (BatchEnv) can fill with plain copies. restore()
+    // rebuilds everything else, and the game plays on as the original would.
+    // Parts may come from another process, so restore() checks them first
+    // and returns false, leaving the game as it was, if they are malformed.
+    struct Parts
+    {
+        Body body;
+        Apples apples;
+        Grid grid;
+        FreeCells freeCells;
+        Rng rng;
+        int32_t score;
+        int32_t bestScore;
+        int32_t pendingGrowth;
+        uint32_t episode;
+        uint32_t tick;
+        uint8_t direction;
+        uint8_t state; // GameState
+    };
+    void save(Parts &parts) const;
+    bool restore(const Parts &parts);
+
+    // Reseeds the apple generator; takes effect from the next spawn
+    void seed(uint64_t seed) { rng.reseed(seed); }
+
+    // The game's own generator, e.g. to jump() it onto a separate stream
+    Rng &random() { return rng; }
+
+    // Starts a new round (snake, apples, score). High score is kept.
+    void reset();
+
+    // Advances the game by one tick. A direction opposite to the current
+    // heading is ignored, as with the arrow keys.
+    GameState step(Direction dir);
+
+    GameState state() const { return gameState; }
+    Direction direction() const { return currentDir; }
+    int score() const { return currentScore; }
+    int highScore() const { return bestScore; }
+    DeathCause deathCause() const
+    {
+        return gameState != GAME_OVER ? DEATH_NONE : headHit == CELL_WALL ? DEATH_WALL : DEATH_SELF;
+    }
+
+    // Cells whose contents changed during the last step(), so observers
+    // can update incrementally. After reset() (or if a step ever changed
+    // more cells than fit) overflow is set: assume everything changed.
+    struct ChangeLog
+    {
+        CellIndex<CELLS> cells[4];
+        uint8_t count;
+        bool overflow;
+    };
+    const ChangeLog &changes() const { return changeLog; }
+    uint32_t episode() const { return episodeCount; } // Bumped by every reset()
+    uint32_t tick() const { return tickCount; }       // Steps since the last reset()
+
+    // Ticks until the snake leaves cell, assuming it eats nothing before
+    // then: 0 if the cell is free now, -1 for a wall. Kept per cell as the
+    // head moves, so it is O(1) rather than a walk along the body.
+    int ticksUntilFree(int cell) const;
+
+    // Whether the head could be on cell ticksFromNow ticks from now (1 =
+    // after the next step) without hitting the body, under the same
+    // assumption
+    bool isSafeAt(int cell, int ticksFromNow) const;
+
+    // Bit d set for each Direction d the next step may take without dying:
+    // not a reversal, and into a cell that is free by then
+    unsigned safeMoves() const;
+
+    // Zobrist hash of the position: body and apple cells, the head, the
+    // order of the body (each segment keyed by the way to the next one),
+    // the direction and pending growth, but not the score, tick or
+    // generator. The keys are XORed in and out as cells change and the
+    // head and tail move, so keeping it costs O(1) a tick.
+    uint64_t hash() const;
+
+    const Body &snake() const { return body; }
+    const Apples &apples() const { return appleList; }
+    const Grid &cells() const { return grid; }
+    static const std::vector<Wall> &walls() { return layout().walls; }
+    static const Grid &wallGrid() { return layout().grid; } // Walls rasterized into cells
+
+    static float worldX(int x) { return float(x - ORIGIN_X); }
+    static float worldZ(int z) { return float(z - ORIGIN_Z); }
+
+private:
+    template <class>
+    friend class BatchEnv;
+
+    // Head moves made so far, wrapping; body cells are stamped with the
+    // move that entered them, so stamps run consecutively tail to head
+    typedef typename std::conditional<(CELLS < 65536), uint16_t, uint32_t>::type Stamp;
+
+    // Everything fixed by the rule set, built once and shared by all games
+    struct Layout
+    {
+        Layout();
+        std::vector<Wall> walls; // Wall boxes in world coordinates, for drawing
+        Grid grid;               // Walls rasterized into cells
+        FreeCells freeCells;     // Spawn cells not covered by a wall
+    };
+    static constexpr ZobristKeys<CELLS> KEYS = makeZobristKeys<CELLS>();
+    static const Layout &layout();
+    static bool inSpawnArea(int x, int z);
+    static int wrap(int v, int size);
+    static bool partsValid(const Parts &parts);
+    static Direction stepDirection(const Segment &from, const Segment &to);
+
+    void initApples();
+    void spawnApple();
+    void setCell(int x, int z, CellType type);
+    void pushHead(const Segment &cell);
+    void rebuild();
+    void hashLinks();
+    void moveSnake();
+    void checkAppleCollision();
+    bool checkWallCollision() const;
+    bool checkSelfCollision() const;
+    void checkGameOver();
+
+    GameState gameState;
+    Direction currentDir;
+    Body body;
+    Stamp enteredAt[CELLS]; // Per body cell: the head move that entered it
+    Stamp headStamp;        // Stamp of the current head
+    uint64_t cellHash;      // Keys of the body and apple cells, the head and the links
+    int pendingGrowth;      // Segments still to add at the tail
+    Apples appleList;
+    Grid grid;           // Walls, body and apples, updated every move
+    FreeCells freeCells; // Spawn cells not covered by anything
+    CellType headHit;    // What the head moved into on the last tick
+    ChangeLog changeLog;
+    uint32_t episodeCount;
+    uint32_t tickCount;
+    int currentScore;
+    int bestScore;
+    Rng rng;
+};
+
+// Complete state of one game (body, apples, grid, score, direction, RNG)
+// as a fixed-size blob. The game owns no pointers and no heap memory, so a
+// snapshot is just its bytes: saving and restoring are a single memcpy,
+// cheap enough to clone a position for every node of a search tree.
+template <class Rules>
+struct GameSnapshot
+{
+    alignas(SnakeGame<Rules>) unsigned char bytes[sizeof(SnakeGame<Rules>)];
+};
+
+// The game as originally shipped
+typedef SnakeGame<ClassicRules> SnakeSim;
+
+// Run-time handle on a game whose rule set is only known at run time.
+// Virtual calls are per step; play() runs a whole move sequence inside the
+// specialized kernel, so batch callers pay for dispatch once.
+class AnySnakeGame
+{
+public:
+    virtual ~AnySnakeGame() {}
+
+    virtual RuleConfig config() const = 0;
+    virtual void reset() = 0;
+    virtual GameState step(Direction dir) = 0;
+
+    // Steps through count moves, starting a new round whenever one ends.
+    // Returns the number of rounds that ended.
+    virtual int play(const Direction *dirs, int count) = 0;
+
+    virtual GameState state() const = 0;
+    virtual int score() const = 0;
+    virtual int highScore() const = 0;
+    virtual int length() const = 0;
+};
+
+// Creates a game for one of the pre-instantiated rule sets (ClassicRules,
+// WrapRules, AppleRainRules). Returns null if no kernel matches config.
+std::unique_ptr<AnySnakeGame> createGame(const RuleConfig &config, uint64_t seed);
+
+#include "snake_sim_impl.h"
+
+extern template class SnakeGame<ClassicRules>;
+extern template class SnakeGame<WrapRules>;
+extern template class SnakeGame<AppleRainRules>;
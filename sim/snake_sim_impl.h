@@ -0,0 +1,480 @@
+#pragma once
+
+// Member definitions for SnakeGame; included from snake_sim.h only.
+
+#include <math.h>
+
+template <class Rules>
+SnakeGame<Rules>::SnakeGame(uint64_t seed)
+    : gameState(PLAYING), currentDir(UP), pendingGrowth(0), headHit(CELL_EMPTY),
+      episodeCount(0), tickCount(0), currentScore(0), bestScore(0), rng(seed)
+{
+    memset(enteredAt, 0, sizeof(enteredAt));
+    headStamp = 0;
+    cellHash = 0;
+    reset();
+}
+
+template <class Rules>
+void SnakeGame<Rules>::reset()
+{
+    // Reset snake to initial state: head in the middle, tail two cells behind
+    body.clear();
+    pushHead({int16_t(ORIGIN_X), int16_t(ORIGIN_Z + 2)});
+    pushHead({int16_t(ORIGIN_X), int16_t(ORIGIN_Z + 1)});
+    pushHead({int16_t(ORIGIN_X), int16_t(ORIGIN_Z)});
+    cellHash = KEYS.head[Grid::index(ORIGIN_X, ORIGIN_Z)]; // setCell() adds the cells
+    hashLinks();
+    pendingGrowth = 0;
+    currentDir = UP;
+    headHit = CELL_EMPTY;
+    changeLog.count = 0;
+    changeLog.overflow = true;
+    episodeCount++;
+    tickCount = 0;
+
+    // Walls are static; the snake is stamped on top of them
+    grid = layout().grid;
+    freeCells = layout().freeCells;
+    for (size_t i = 0; i < body.size(); i++)
+        setCell(body[i].x, body[i].z, CELL_BODY);
+
+    // Clear apples and spawn new ones
+    initApples();
+
+    // Reset score (keep high score)
+    currentScore = 0;
+
+    gameState = PLAYING;
+}
+
+template <class Rules>
+void SnakeGame<Rules>::save(Snapshot &snapshot) const
+{
+    static_assert(std::is_trivially_copyable<SnakeGame>::value, "snapshots are raw copies");
+    memcpy(snapshot.bytes, this, sizeof(*this));
+}
+
+template <class Rules>
+void SnakeGame<Rules>::restore(const Snapshot &snapshot)
+{
+    memcpy(this, snapshot.bytes, sizeof(*this));
+}
+
+template <class Rules>
+void SnakeGame<Rules>::save(Parts &parts) const
+{
+    parts.body = body;
+    parts.apples = appleList;
+    parts.grid = grid;
+    parts.freeCells = freeCells;
+    parts.rng = rng;
+    parts.score = currentScore;
+    parts.bestScore = bestScore;
+    parts.pendingGrowth = pendingGrowth;
+    parts.episode = episodeCount;
+    parts.tick = tickCount;
+    parts.direction = uint8_t(currentDir);
+    parts.state = uint8_t(gameState);
+}
+
+// Everything restore() indexes by: enums in range, the body and apples on
+// the board, the cell tables self-consistent
+template <class Rules>
+bool SnakeGame<Rules>::partsValid(const Parts &parts)
+{
+    if (parts.direction > RIGHT || parts.state > GAME_OVER || parts.pendingGrowth < 0)
+        return false;
+    if (parts.body.empty() || parts.body.size() > Body::capacity())
+        return false;
+    for (size_t k = 0; k < parts.body.size(); k++)
+    {
+        if (unsigned(parts.body[k].x) >= unsigned(WIDTH) || unsigned(parts.body[k].z) >= unsigned(HEIGHT))
+            return false;
+    }
+    for (int cell = 0; cell < CELLS; cell++)
+    {
+        if (parts.grid.at(cell) > CELL_APPLE)
+            return false;
+    }
+    return parts.apples.consistent() && parts.freeCells.consistent();
+}
+
+template <class Rules>
+bool SnakeGame<Rules>::restore(const Parts &parts)
+{
+    if (!partsValid(parts))
+        return false;
+    gameState = GameState(parts.state);
+    currentDir = Direction(parts.direction);
+    body = parts.body;
+    pendingGrowth = parts.pendingGrowth;
+    appleList = parts.apples;
+    grid = parts.grid;
+    freeCells = parts.freeCells;
+    episodeCount = parts.episode;
+    tickCount = parts.tick;
+    currentScore = parts.score;
+    bestScore = parts.bestScore;
+    rng = parts.rng;
+    rebuild();
+    return true;
+}
+
+template <class Rules>
+GameState SnakeGame<Rules>::step(Direction dir)
+{
+    if (gameState != PLAYING)
+        return gameState;
+
+    // Same rule as the arrow keys: no reversing into the neck
+    switch (dir)
+    {
+    case UP:
+        if (currentDir != DOWN)
+            currentDir = UP;
+        break;
+    case DOWN:
+        if (currentDir != UP)
+            currentDir = DOWN;
+        break;
+    case LEFT:
+        if (currentDir != RIGHT)
+            currentDir = LEFT;
+        break;
+    case RIGHT:
+        if (currentDir != LEFT)
+            currentDir = RIGHT;
+        break;
+    }
+
+    changeLog.count = 0;
+    changeLog.overflow = false;
+    tickCount++;
+
+    moveSnake();
+    checkAppleCollision();
+    checkGameOver();
+    return gameState;
+}
+
+// Apples spawn away from the edges, SPAWN_MARGIN cells in on each side
+template <class Rules>
+bool SnakeGame<Rules>::inSpawnArea(int x, int z)
+{
+    return unsigned(x - Rules::SPAWN_MARGIN) < unsigned(WIDTH - 2 * Rules::SPAWN_MARGIN) &&
+           unsigned(z - Rules::SPAWN_MARGIN) < unsigned(HEIGHT - 2 * Rules::SPAWN_MARGIN);
+}
+
+// The move that takes a segment at from to the adjacent cell to
+template <class Rules>
+Direction SnakeGame<Rules>::stepDirection(const Segment &from, const Segment &to)
+{
+    if (to.x == from.x)
+    {
+        int dz = to.z - from.z;
+        return dz == -1 || dz == HEIGHT - 1 ? UP : DOWN;
+    }
+    int dx = to.x - from.x;
+    return dx == 1 || dx == -(WIDTH - 1) ? RIGHT : LEFT;
+}
+
+// Folds a coordinate back onto the board on wrapping boards. Power-of-two
+// sizes reduce to a mask; walled boards never leave the grid at all.
+template <class Rules>
+int SnakeGame<Rules>::wrap(int v, int size)
+{
+    if constexpr (!Rules::WRAP)
+        return v;
+    if ((size & (size - 1)) == 0)
+        return v & (size - 1);
+    return v < 0 ? v + size : (v >= size ? v - size : v);
+}
+
+//Apple Functions 
+template <class Rules>
+void SnakeGame<Rules>::spawnApple()
+{
+    if (appleList.full())
+        return;
+
+    // Every free cell is a valid spot, so one pick always succeeds
+    if (freeCells.empty())
+        return;
+
+    int cell = freeCells[rng.below(uint32_t(freeCells.size()))];
+    int cx = Grid::cellX(cell);
+    int cz = Grid::cellZ(cell);
+    setCell(cx, cz, CELL_APPLE);
+
+    Apple newApple;
+    newApple.x = int16_t(cx);
+    newApple.z = int16_t(cz);
+    appleList.add(newApple);
+}
+
+template <class Rules>
+void SnakeGame<Rules>::checkAppleCollision()
+{
+    // The grid already told us whether the head landed on an apple
+    if (headHit != CELL_APPLE || gameState != PLAYING)
+        return;
+
+    const Segment &head = body.head();
+    int slot = appleList.find(Grid::index(head.x, head.z));
+    if (slot < 0)
+        return;
+
+    // Increase score and update high score
+    currentScore++;
+    if (currentScore > bestScore)
+        bestScore = currentScore;
+
+    // Grow snake: the tail stays put on the next moves instead of
+    // extrapolating a new segment (which could land inside a wall)
+    pendingGrowth += Rules::GROWTH;
+
+    // Remove apple (the head already took over its cell)
+    appleList.removeAt(slot);
+
+    // Spawn new apple
+    spawnApple();
+}
+
+template <class Rules>
+void SnakeGame<Rules>::initApples()//places the apples
+{
+    appleList.clear();
+    for (int i = 0; i < Rules::APPLES; i++)
+        spawnApple();
+}
+
+//Wall Functions 
+template <class Rules>
+const typename SnakeGame<Rules>::Layout &SnakeGame<Rules>::layout()
+{
+    static const Layout shared;
+    return shared;
+}
+
+template <class Rules>
+SnakeGame<Rules>::Layout::Layout()//places the walls
+{
+    if (!Rules::WRAP)
+    {
+        // Boundary walls along the outermost cells
+        float midX = (WIDTH - 1) / 2.0f - ORIGIN_X;
+        float midZ = (HEIGHT - 1) / 2.0f - ORIGIN_Z;
+        float spanX = (WIDTH - 1) + 0.5f;
+        float spanZ = (HEIGHT - 1) + 0.5f;
+        walls.push_back({midX, float(-ORIGIN_Z), spanX, 0.5f});             // South
+        walls.push_back({midX, float(HEIGHT - 1 - ORIGIN_Z), spanX, 0.5f}); // North
+        walls.push_back({float(-ORIGIN_X), midZ, 0.5f, spanZ});             // West
+        walls.push_back({float(WIDTH - 1 - ORIGIN_X), midZ, 0.5f, spanZ});  // East
+    }
+
+    if (Rules::INTERIOR_WALLS)
+    {
+        walls.push_back({-4, -4, 4, 0.8f});
+        walls.push_back({5, 3, 0.8f, 6});
+    }
+
+    // Rasterize once: a cell is wall if its center lies inside a wall
+    for (const auto &wall : walls)
+    {
+        float wall_half_w = wall.w / 2.0f;
+        float wall_half_d = wall.d / 2.0f;
+
+        int min_x = int(ceil(wall.x - wall_half_w)) + ORIGIN_X;
+        int max_x = int(floor(wall.x + wall_half_w)) + ORIGIN_X;
+        int min_z = int(ceil(wall.z - wall_half_d)) + ORIGIN_Z;
+        int max_z = int(floor(wall.z + wall_half_d)) + ORIGIN_Z;
+
+        for (int z = min_z; z <= max_z; z++)
+            for (int x = min_x; x <= max_x; x++)
+                if (x >= 0 && x < WIDTH && z >= 0 && z < HEIGHT)
+                    grid.set(x, z, CELL_WALL);
+    }
+
+    for (int cell = 0; cell < CELLS; cell++)
+    {
+        if (inSpawnArea(Grid::cellX(cell), Grid::cellZ(cell)) && grid.at(cell) == CELL_EMPTY)
+            freeCells.insert(cell);
+    }
+}
+
+// Keeps the grid and the set of free spawn cells in step
+template <class Rules>
+void SnakeGame<Rules>::setCell(int x, int z, CellType type)
+{
+    int cell = Grid::index(x, z);
+    cellHash ^= KEYS.cell[cell][grid.at(cell)] ^ KEYS.cell[cell][type];
+    grid.set(x, z, type);
+    if (changeLog.count < 4)
+        changeLog.cells[changeLog.count++] = CellIndex<CELLS>(cell);
+    else
+        changeLog.overflow = true;
+    if (!inSpawnArea(x, z))
+        return;
+    if (type == CELL_EMPTY)
+        freeCells.insert(cell);
+    else
+        freeCells.erase(cell);
+}
+
+// Collision Detection: moveSnake() records what the head ran into
+template <class Rules>
+bool SnakeGame<Rules>::checkWallCollision() const
+{
+    return headHit == CELL_WALL;
+}
+
+template <class Rules>
+bool SnakeGame<Rules>::checkSelfCollision() const
+{
+    return headHit == CELL_BODY;
+}
+
+template <class Rules>
+void SnakeGame<Rules>::pushHead(const Segment &cell)
+{
+    body.pushHead(cell);
+    headStamp++;
+    enteredAt[Grid::index(cell.x, cell.z)] = headStamp;
+}
+
+// Body stamps, hash and change log from scratch, for games filled in from
+// outside (restore(Parts), BatchEnv::copyGame())
+template <class Rules>
+void SnakeGame<Rules>::rebuild()
+{
+    for (size_t k = 0; k < body.size(); k++)
+        enteredAt[Grid::index(body[k].x, body[k].z)] = Stamp(body.size() - 1 - k);
+    headStamp = Stamp(body.size() - 1);
+    headHit = CELL_EMPTY;
+    changeLog.count = 0;
+    changeLog.overflow = true;
+
+    cellHash = KEYS.head[Grid::index(body.head().x, body.head().z)];
+    for (int cell = 0; cell < CELLS; cell++)
+        cellHash ^= KEYS.cell[cell][grid.at(cell)];
+    hashLinks();
+}
+
+// XORs in the link key of every segment but the head
+template <class Rules>
+void SnakeGame<Rules>::hashLinks()
+{
+    for (size_t k = 1; k < body.size(); k++)
+        cellHash ^= KEYS.link[Grid::index(body[k].x, body[k].z)][stepDirection(body[k], body[k - 1])];
+}
+
+template <class Rules>
+uint64_t SnakeGame<Rules>::hash() const
+{
+    return cellHash ^ KEYS.direction[currentDir] ^ KEYS.growth[pendingGrowth & 63];
+}
+
+// A body cell frees when the tail pops off it. Stamps count up from the
+// tail one per segment, and the tail only pops once pending growth is paid
+template <class Rules>
+int SnakeGame<Rules>::ticksUntilFree(int cell) const
+{
+    CellType type = grid.at(cell);
+    if (type == CELL_WALL)
+        return -1;
+    if (type != CELL_BODY)
+        return 0;
+    const Segment &tail = body.tail();
+    Stamp behind = Stamp(enteredAt[cell] - enteredAt[Grid::index(tail.x, tail.z)]);
+    return int(behind) + 1 + pendingGrowth;
+}
+
+template <class Rules>
+bool SnakeGame<Rules>::isSafeAt(int cell, int ticksFromNow) const
+{
+    int wait = ticksUntilFree(cell);
+    return wait >= 0 && wait <= ticksFromNow;
+}
+
+// All four neighbours at once, branch-free, so the compiler can do the
+// lanes side by side
+template <class Rules>
+unsigned SnakeGame<Rules>::safeMoves() const
+{
+    const Segment &head = body.head();
+    const Segment &tail = body.tail();
+    const int cell[4] = {Grid::index(head.x, wrap(head.z - 1, HEIGHT)), Grid::index(head.x, wrap(head.z + 1, HEIGHT)),
+                         Grid::index(wrap(head.x - 1, WIDTH), head.z), Grid::index(wrap(head.x + 1, WIDTH), head.z)};
+    const Stamp tailStamp = enteredAt[Grid::index(tail.x, tail.z)];
+
+    unsigned mask = 0;
+    for (int d = 0; d < 4; d++)
+    {
+        uint8_t type = grid.at(cell[d]);
+        // Only the tail cell with no growth owed frees in time for the next step
+        unsigned bodyFrees = Stamp(enteredAt[cell[d]] - tailStamp) == 0 && pendingGrowth == 0;
+        unsigned ok = (type == CELL_EMPTY) | (type == CELL_APPLE) | ((type == CELL_BODY) & bodyFrees);
+        mask |= ok << d;
+    }
+    return mask & ~(1u << (currentDir ^ 1));
+}
+
+// Game Logic Functions
+template <class Rules>
+void SnakeGame<Rules>::moveSnake()
+{
+    if (gameState != PLAYING)
+        return;
+
+    // Calculate new head position based on direction
+    Segment newHead = body.head();
+    switch (currentDir)
+    {
+    case UP:
+        newHead.z = int16_t(wrap(newHead.z - 1, HEIGHT));
+        break;
+    case DOWN:
+        newHead.z = int16_t(wrap(newHead.z + 1, HEIGHT));
+        break;
+    case LEFT:
+        newHead.x = int16_t(wrap(newHead.x - 1, WIDTH));
+        break;
+    case RIGHT:
+        newHead.x = int16_t(wrap(newHead.x + 1, WIDTH));
+        break;
+    }
+
+    // Remove tail first, unless an apple eaten earlier still owes us growth,
+    // so the head may follow into the cell the tail is leaving
+    if (pendingGrowth > 0)
+    {
+        pendingGrowth--;
+    }
+    else
+    {
+        const Segment &tail = body.tail();
+        if (body.size() > 1)
+            cellHash ^= KEYS.link[Grid::index(tail.x, tail.z)][stepDirection(tail, body[body.size() - 2])];
+        setCell(tail.x, tail.z, CELL_EMPTY);
+        body.popTail();
+    }
+
+    // Insert new head at front
+    // The old head becomes a segment linked to the new one
+    headHit = grid.at(newHead.x, newHead.z);
+    int oldHead = Grid::index(body.head().x, body.head().z);
+    cellHash ^= KEYS.head[oldHead] ^ KEYS.head[Grid::index(newHead.x, newHead.z)] ^ KEYS.link[oldHead][currentDir];
+    pushHead(newHead);
+    if (headHit != CELL_WALL)
+        setCell(newHead.x, newHead.z, CELL_BODY);
+}
+
+template <class Rules>
+void SnakeGame<Rules>::checkGameOver()
+{
+    if (checkWallCollision() || checkSelfCollision())
+    {
+        gameState = GAME_OVER;
+    }
+}
@@ -0,0 +1,36 @@
+#include "transposition_table.h"
+
+#include <new>
+
+namespace
+{
+size_t bucketsFor(size_t bytes)
+{
+    size_t n = 1;
+    while (n * 2 * 64 <= bytes)
+        n *= 2;
+    return n;
+}
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t bytes)
+    : memory(bucketsFor(bytes) * sizeof(Bucket)), buckets(nullptr), mask(bucketsFor(bytes) - 1)
+{
+    size_t count = size_t(mask) + 1;
+    buckets = memory.allocate<Bucket>(count);
+    for (size_t i = 0; i < count; i++)
+        new (&buckets[i]) Bucket();
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i <= mask; i++)
+    {
+        for (int k = 0; k < WAYS; k++)
+        {
+            buckets[i].check[k].store(0, std::memory_order_relaxed);
+            buckets[i].data[k].store(0, std::memory_order_relaxed);
+        }
+    }
+}
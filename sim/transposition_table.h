@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "arena.h"
+
+// Fixed-size hash table from 64-bit position hashes (SnakeGame::hash()) to
+// 64-bit data, shared by search threads without locks. Each 64-byte bucket
+// holds four entries, and an entry is two words, key ^ data and data,
+// written with relaxed atomics (Hyatt and Mann's lockless hashing): if two
+// threads' writes to an entry interleave, the words no longer XOR back to
+// the key and a reader sees a miss rather than another position's data.
+//
+// The top 16 bits of data are its weight (a visit count, a search depth):
+// a store for a key not in the bucket replaces the lightest entry. Data 0
+// reads as empty. The table is allocated once, from an Arena so large
+// tables get huge pages.
+class TranspositionTable
+{
+public:
+    static constexpr int WAYS = 4;
+
+    // Buckets: bytes / 64 rounded down to a power of two, at least one.
+    // Throws std::bad_alloc if the memory can't be mapped.
+    explicit TranspositionTable(size_t bytes);
+
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    static uint64_t pack(uint16_t weight, uint64_t payload) { return (uint64_t(weight) << 48) | (payload & PAYLOAD); }
+    static uint16_t weightOf(uint64_t data) { return uint16_t(data >> 48); }
+    static uint64_t payloadOf(uint64_t data) { return data & PAYLOAD; }
+
+    bool find(uint64_t key, uint64_t &data) const
+    {
+        const Bucket &b = buckets[key & mask];
+        for (int k = 0; k < WAYS; k++)
+        {
+            uint64_t d = b.data[k].load(std::memory_order_relaxed);
+            if (d != 0 && (b.check[k].load(std::memory_order_relaxed) ^ d) == key)
+            {
+                data = d;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(uint64_t key, uint64_t data)
+    {
+        Bucket &b = buckets[key & mask];
+        int slot = 0;
+        uint16_t lightest = UINT16_MAX;
+        for (int k = 0; k < WAYS; k++)
+        {
+            uint64_t d = b.data[k].load(std::memory_order_relaxed);
+            if ((b.check[k].load(std::memory_order_relaxed) ^ d) == key)
+            {
+                slot = k;
+                break;
+            }
+            if (weightOf(d) < lightest)
+            {
+                slot = k;
+                lightest = weightOf(d);
+            }
+        }
+        b.check[slot].store(key ^ data, std::memory_order_relaxed);
+        b.data[slot].store(data, std::memory_order_relaxed);
+    }
+
+    // Not safe while other threads use the table
+    void clear();
+
+    size_t bucketCount() const { return size_t(mask) + 1; }
+
+private:
+    static constexpr uint64_t PAYLOAD = (uint64_t(1) << 48) - 1;
+
+    struct alignas(64) Bucket
+    {
+        std::atomic<uint64_t> check[WAYS];
+        std::atomic<uint64_t> data[WAYS];
+    };
+
+    Arena memory;
+    Bucket *buckets;
+    uint64_t mask;
+};
@@ -0,0 +1,149 @@
+#include "work_stealing_pool.h"
+
+#include <cassert>
+
+// The pool whose worker is running on this thread, if any
+static thread_local const WorkStealingPool *workerOf = nullptr;
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+    : busy(false), generation(0), running(0), stopping(false), task(nullptr), taskCtx(nullptr)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    slices = std::vector<Slice>(threads);
+    for (auto &slice : slices)
+        slice.range.store(0, std::memory_order_relaxed);
+
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void WorkStealingPool::runErased(uint64_t count, TaskFn fn, void *ctx)
+{
+    if (count == 0)
+        return;
+    assert(workerOf != this && "run() called from one of the pool's own workers");
+    bool wasBusy = busy.exchange(true, std::memory_order_acquire);
+    assert(!wasBusy && "run() called while another run() is in progress");
+    (void)wasBusy;
+
+    // Equal slices up front; stealing evens out whatever is left over
+    unsigned n = size();
+    for (unsigned i = 0; i < n; i++)
+    {
+        uint32_t begin = uint32_t(count * i / n);
+        uint32_t end = uint32_t(count * (i + 1) / n);
+        slices[i].range.store(pack(begin, end), std::memory_order_relaxed);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    task = fn;
+    taskCtx = ctx;
+    running = n;
+    generation++;
+    wake.notify_all();
+    finished.wait(lock, [this] { return running == 0; });
+    busy.store(false, std::memory_order_release);
+}
+
+void WorkStealingPool::workerLoop(unsigned id)
+{
+    workerOf = this;
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        drain(id);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0)
+            finished.notify_one();
+    }
+}
+
+void WorkStealingPool::drain(unsigned id)
+{
+    uint32_t index;
+    for (;;)
+    {
+        while (takeOwn(id, index))
+            task(taskCtx, index, id);
+        if (!steal(id))
+            return;
+    }
+}
+
+// Owner end: take the first index of our own slice
+bool WorkStealingPool::takeOwn(unsigned id, uint32_t &index)
+{
+    std::atomic<uint64_t> &range = slices[id].range;
+    uint64_t r = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        uint32_t begin = beginOf(r), end = endOf(r);
+        if (begin >= end)
+            return false;
+        if (range.compare_exchange_weak(r, pack(begin + 1, end), std::memory_order_acq_rel))
+        {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+// Thief end: move the back half of the largest other slice into ours.
+// Only called once our own slice is empty, so nobody else writes to it.
+bool WorkStealingPool::steal(unsigned id)
+{
+    for (;;)
+    {
+        unsigned victim = id;
+        uint32_t largest = 0;
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < size(); i++)
+        {
+            if (i == id)
+                continue;
+            uint64_t r = slices[i].range.load(std::memory_order_acquire);
+            uint32_t left = beginOf(r) < endOf(r) ? endOf(r) - beginOf(r) : 0;
+            if (left > largest)
+            {
+                largest = left;
+                victim = i;
+                seen = r;
+            }
+        }
+        if (victim == id)
+            return false; // Nothing left anywhere
+
+        uint32_t begin = beginOf(seen), end = endOf(seen);
+        uint32_t mid = end - (end - begin + 1) / 2;
+        if (slices[victim].range.compare_exchange_strong(seen, pack(begin, mid), std::memory_order_acq_rel))
+        {
+            slices[id].range.store(pack(mid, end), std::memory_order_release);
+            return true;
+        }
+        // Lost a race with the owner or another thief; look again
+    }
+}
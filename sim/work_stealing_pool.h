@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads that run a parallel loop over [0, count).
+// Each worker starts with an equal slice of the index range and takes
+// indices from its front; a worker that runs dry steals the back half of
+// the largest remaining slice. Slices are single atomic words updated by
+// CAS, so neither taking nor stealing work ever takes a lock. The only
+// mutex is around starting and finishing a run().
+class WorkStealingPool
+{
+public:
+    // threads = 0 uses every hardware thread
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    unsigned size() const { return unsigned(workers.size()); }
+
+    // Calls fn(index, worker) once for every index in [0, count) and returns
+    // when all calls are done. worker is in [0, size()), so callers can keep
+    // per-worker scratch without locking. count must fit in 32 bits.
+    // Only one run() at a time: callers must not overlap, and fn must not
+    // call run() on the same pool (a worker would wait on itself).
+    template <class Fn>
+    void run(uint64_t count, Fn &fn)
+    {
+        runErased(count, &callFn<Fn>, &fn);
+    }
+
+private:
+    typedef void (*TaskFn)(void *ctx, uint64_t index, unsigned worker);
+
+    template <class Fn>
+    static void callFn(void *ctx, uint64_t index, unsigned worker)
+    {
+        (*static_cast<Fn *>(ctx))(index, worker);
+    }
+
+    // One worker's remaining slice, begin in the low half, end in the high
+    // half, padded to its own cache line so owners don't false-share
+    struct alignas(64) Slice
+    {
+        std::atomic<uint64_t> range;
+    };
+
+    static uint64_t pack(uint32_t begin, uint32_t end) { return uint64_t(begin) | (uint64_t(end) << 32); }
+    static uint32_t beginOf(uint64_t r) { return uint32_t(r); }
+    static uint32_t endOf(uint64_t r) { return uint32_t(r >> 32); }
+
+    void runErased(uint64_t count, TaskFn fn, void *ctx);
+    void workerLoop(unsigned id);
+    void drain(unsigned id);
+    bool takeOwn(unsigned id, uint32_t &index);
+    bool steal(unsigned id);
+
+    std::vector<std::thread> workers;
+    std::vector<Slice> slices;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::atomic<bool> busy; // A run() is in progress; checked by assert
+    uint64_t generation;    // Bumped for every run()
+    unsigned running;    // Workers still busy with the current run
+    bool stopping;
+
+    TaskFn task;
+    void *taskCtx;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+// Zobrist keys for a board of CELLS cells. Generated at compile time
+// (SplitMix64 from a fixed seed), so they need no setup before the first
+// game and a position hashes the same in every process.
+template <int CELLS>
+struct ZobristKeys
+{
+    uint64_t cell[CELLS][4]; // By CellType; 0 for empty and wall
+    uint64_t head[CELLS];
+    uint64_t link[CELLS][4]; // Body cell by the direction to the next segment headwards
+    uint64_t direction[4];
+    uint64_t growth[64]; // By pending growth, mod 64; 0 for none
+};
+
+constexpr uint64_t zobristMix(uint64_t &state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+template <int CELLS>
+constexpr ZobristKeys<CELLS> makeZobristKeys()
+{
+    ZobristKeys<CELLS> keys{};
+    uint64_t state = 0x2545f4914f6cdd1dull;
+    for (int c = 0; c < CELLS; c++)
+    {
+        keys.cell[c][2] = zobristMix(state); // CELL_BODY
+        keys.cell[c][3] = zobristMix(state); // CELL_APPLE
+        keys.head[c] = zobristMix(state);
+        for (int d = 0; d < 4; d++)
+            keys.link[c][d] = zobristMix(state);
+    }
+    for (int d = 0; d < 4; d++)
+        keys.direction[d] = zobristMix(state);
+    for (int g = 1; g < 64; g++)
+        keys.growth[g] = zobristMix(state);
+    return keys;
+}
@@ -0,0 +1,104 @@
+// Checks that step() and reset() never touch the heap once warmed up, for
+// SnakeGame and BatchEnv under every pre-instantiated rule set.
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "batch_env.h"
+#include "rng.h"
+#include "snake_sim.h"
+#include "test_moves.h"
+
+namespace
+{
+
+const int TICKS = 20000;
+
+template <class Rules>
+bool checkGame(const char *name)
+{
+    SnakeGame<Rules> game(1);
+    Rng rng(2);
+    for (int t = 0; t < 100; t++)
+    {
+        if (game.step(pickMove(game.safeMoves(), rng)) == GAME_OVER)
+            game.reset();
+    }
+
+    AllocScope scope;
+    int rounds = 0;
+    for (int t = 0; t < TICKS; t++)
+    {
+        if (game.step(pickMove(game.safeMoves(), rng)) == GAME_OVER || t % 1000 == 999)
+        {
+            game.reset();
+            rounds++;
+        }
+    }
+    AllocCounts counts = scope.delta();
+    if (counts.allocations != 0)
+    {
+        printf("FAIL %s SnakeGame: %llu allocations in %d ticks, %d resets\n", name,
+               (unsigned long long)counts.allocations, TICKS, rounds);
+        return false;
+    }
+    printf("ok   %s SnakeGame: %d ticks, %d resets\n", name, TICKS, rounds);
+    return true;
+}
+
+template <class Rules>
+bool checkBatch(const char *name)
+{
+    const int n = 64;
+    BatchEnv<Rules> env(n, 1);
+    std::vector<uint8_t> actions(n);
+    Rng rng(2);
+    env.step(actions.data());
+    env.reset();
+
+    AllocScope scope;
+    for (int t = 0; t < TICKS / 10; t++)
+    {
+        for (int i = 0; i < n; i++)
+            actions[i] = uint8_t(rng.below(4));
+        env.step(actions.data());
+        if (t % 500 == 499)
+            env.reset();
+    }
+    AllocCounts counts = scope.delta();
+    if (counts.allocations != 0)
+    {
+        printf("FAIL %s BatchEnv: %llu allocations\n", name, (unsigned long long)counts.allocations);
+        return false;
+    }
+    printf("ok   %s BatchEnv: %d ticks of %d games\n", name, TICKS / 10, n);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    // The counters must see this thread's allocations, or every check
+    // below would pass for nothing
+    {
+        AllocScope scope;
+        std::unique_ptr<int> probe(new int(0));
+        if (scope.delta().allocations != 1)
+        {
+            printf("FAIL allocation counters are not linked in\n");
+            return 1;
+        }
+    }
+
+    bool ok = true;
+    ok &= checkGame<ClassicRules>("classic");
+    ok &= checkGame<WrapRules>("wrap");
+    ok &= checkGame<AppleRainRules>("apple-rain");
+    ok &= checkBatch<ClassicRules>("classic");
+    ok &= checkBatch<WrapRules>("wrap");
+    ok &= checkBatch<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// Checks BfsAutopilot's first step against shortest paths found by a
+// plain queue BFS from each of the head's safe neighbours, over positions
+// from its own play, under every pre-instantiated rule set.
+
+#include <climits>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "autopilot.h"
+#include "snake_sim.h"
+
+namespace
+{
+
+const int TICKS = 20000;
+
+// Steps from start to the nearest apple, start counting as the first; the
+// path may only go on through empty and apple cells. INT_MAX if none.
+template <class Rules>
+int naiveDistance(const SnakeGame<Rules> &game, int start, std::vector<int> &dist)
+{
+    typedef SnakeGame<Rules> Game;
+    static const int DX[4] = {0, 0, -1, 1};
+    static const int DZ[4] = {-1, 1, 0, 0};
+
+    dist.assign(Game::CELLS, -1);
+    std::vector<int> queue(1, start);
+    dist[start] = 1;
+    for (size_t k = 0; k < queue.size(); k++)
+    {
+        int cell = queue[k];
+        if (game.cells().at(cell) == CELL_APPLE)
+            return dist[cell];
+        int x = Game::Grid::cellX(cell), z = Game::Grid::cellZ(cell);
+        for (int d = 0; d < 4; d++)
+        {
+            int nx = x + DX[d], nz = z + DZ[d];
+            if (Rules::WRAP)
+            {
+                nx = (nx + Game::WIDTH) % Game::WIDTH;
+                nz = (nz + Game::HEIGHT) % Game::HEIGHT;
+            }
+            else if (nx < 0 || nx >= Game::WIDTH || nz < 0 || nz >= Game::HEIGHT)
+                continue;
+            int next = Game::Grid::index(nx, nz);
+            CellType type = game.cells().at(next);
+            if (dist[next] < 0 && (type == CELL_EMPTY || type == CELL_APPLE))
+            {
+                dist[next] = dist[cell] + 1;
+                queue.push_back(next);
+            }
+        }
+    }
+    return INT_MAX;
+}
+
+template <class Rules>
+bool checkRules(const char *name)
+{
+    typedef SnakeGame<Rules> Game;
+    static const int DX[4] = {0, 0, -1, 1};
+    static const int DZ[4] = {-1, 1, 0, 0};
+
+    std::unique_ptr<Game> game(new Game(12));
+    std::unique_ptr<BfsAutopilot<Rules>> pilot(new BfsAutopilot<Rules>());
+    pilot->reset(0);
+    std::vector<int> dist;
+    int checked = 0, intoTail = 0, deaths = 0;
+    for (int t = 0; t < TICKS; t++)
+    {
+        Direction move = (*pilot)(*game);
+
+        // Shortest path length through each safe first step
+        unsigned safe = game->safeMoves();
+        const Segment &head = game->snake().head(), &tail = game->snake().tail();
+        int best = INT_MAX, through[4], cell[4];
+        for (int d = 0; d < 4; d++)
+        {
+            through[d] = INT_MAX;
+            int x = head.x + DX[d], z = head.z + DZ[d];
+            if (Rules::WRAP)
+            {
+                x = (x + Game::WIDTH) % Game::WIDTH;
+                z = (z + Game::HEIGHT) % Game::HEIGHT;
+            }
+            cell[d] = Game::Grid::index(x, z);
+            if (!((safe >> d) & 1))
+                continue;
+            through[d] = naiveDistance(*game, cell[d], dist);
+            best = through[d] < best ? through[d] : best;
+        }
+
+        if (best != INT_MAX)
+        {
+            if (through[move] != best)
+            {
+                printf("FAIL %s: after %d ticks moved %d, a %d step path; shortest is %d\n", name, game->tick(),
+                       int(move), through[move], best);
+                return false;
+            }
+            checked++;
+            intoTail += cell[move] == Game::Grid::index(tail.x, tail.z);
+        }
+        else if (safe && !((safe >> move) & 1))
+        {
+            printf("FAIL %s: after %d ticks moved %d, not a safe move\n", name, game->tick(), int(move));
+            return false;
+        }
+
+        if (game->step(move) == GAME_OVER)
+        {
+            game->reset();
+            pilot->reset(0);
+            deaths++;
+        }
+    }
+    printf("ok   %s: %d first steps checked, %d into the tail, %d deaths\n", name, checked, intoTail, deaths);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= checkRules<ClassicRules>("classic");
+    ok &= checkRules<WrapRules>("wrap");
+    ok &= checkRules<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+// Checks WorkStealingPool and runEpisodes(): every index runs exactly once
+// however uneven the work, and episode results don't depend on the number
+// of threads.
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "episode_runner.h"
+#include "work_stealing_pool.h"
+
+namespace
+{
+
+bool checkEveryIndexOnce()
+{
+    const uint64_t COUNTS[] = {1, 3, 64, 1000, 100003};
+    WorkStealingPool pool(4);
+    for (uint64_t count : COUNTS)
+    {
+        std::unique_ptr<std::atomic<uint32_t>[]> calls(new std::atomic<uint32_t>[count]);
+        for (uint64_t i = 0; i < count; i++)
+            calls[i].store(0);
+        std::atomic<uint32_t> badWorker(0);
+        auto fn = [&](uint64_t index, unsigned worker)
+        {
+            calls[index]++;
+            if (worker >= pool.size())
+                badWorker++;
+            // Uneven work, so workers run dry early and steal
+            volatile uint64_t spin = 0;
+            for (uint64_t k = 0; k < (index % 97 == 0 ? 20000 : 10); k++)
+                spin += k;
+        };
+        for (int run = 0; run < 3; run++)
+            pool.run(count, fn);
+        for (uint64_t i = 0; i < count; i++)
+        {
+            if (calls[i].load() != 3)
+            {
+                printf("FAIL pool: index %llu of %llu ran %u times in 3 runs\n", (unsigned long long)i,
+                       (unsigned long long)count, calls[i].load());
+                return false;
+            }
+        }
+        if (badWorker.load())
+        {
+            printf("FAIL pool: worker index out of range\n");
+            return false;
+        }
+    }
+    printf("ok   pool: every index once per run\n");
+    return true;
+}
+
+template <class Rules>
+bool checkThreadCounts(const char *name)
+{
+    const uint64_t FIRST = 100, COUNT = 2000;
+    const int MAX_TICKS = 2000;
+    std::vector<EpisodeResult> one(COUNT), four(COUNT);
+    WorkStealingPool single(1), quad(4);
+    runEpisodes<Rules>(single, GreedyPolicy(), FIRST, COUNT, MAX_TICKS, one.data());
+    runEpisodes<Rules>(quad, GreedyPolicy(), FIRST, COUNT, MAX_TICKS, four.data());
+    for (uint64_t i = 0; i < COUNT; i++)
+    {
+        const EpisodeResult &a = one[i], &b = four[i];
+        if (a.seed != FIRST + i || b.seed != a.seed || b.score != a.score || b.length != a.length ||
+            b.ticks != a.ticks || b.died != a.died || b.cause != a.cause)
+        {
+            printf("FAIL %s runEpisodes: seed %llu differs between 1 and 4 threads\n", name,
+                   (unsigned long long)(FIRST + i));
+            return false;
+        }
+    }
+    printf("ok   %s runEpisodes: %llu episodes alike at 1 and 4 threads\n", name, (unsigned long long)COUNT);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= checkEveryIndexOnce();
+    ok &= checkThreadCounts<ClassicRules>("classic");
+    ok &= checkThreadCounts<WrapRules>("wrap");
+    ok &= checkThreadCounts<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
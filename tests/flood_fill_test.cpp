@@ -0,0 +1,141 @@
+// Checks ReachableArea against a plain queue BFS over the grid bytes, with
+// the scalar sweep and (where the CPU has it) the AVX2 one: from the
+// head's neighbours and a few random cells, every tick of random play,
+// under every pre-instantiated rule set.
+
+#include <climits>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "flood_fill.h"
+#include "rng.h"
+#include "snake_sim.h"
+#include "test_moves.h"
+
+namespace
+{
+
+const int TICKS = 3000;
+
+// Reach the slow way: a cell-by-cell BFS over empty, apple and tail cells
+template <class Rules>
+Reach naiveReach(const SnakeGame<Rules> &game, int start)
+{
+    typedef SnakeGame<Rules> Game;
+    static const int DX[4] = {0, 0, -1, 1};
+    static const int DZ[4] = {-1, 1, 0, 0};
+
+    const Segment &t = game.snake().tail();
+    const int tail = Game::Grid::index(t.x, t.z);
+    auto open = [&](int cell)
+    {
+        CellType type = game.cells().at(cell);
+        return type == CELL_EMPTY || type == CELL_APPLE || cell == tail;
+    };
+
+    Reach reach = {0, false};
+    if (!open(start))
+        return reach;
+
+    std::vector<uint8_t> seen(Game::CELLS);
+    std::vector<int> queue(1, start);
+    seen[start] = 1;
+    for (size_t k = 0; k < queue.size(); k++)
+    {
+        int x = Game::Grid::cellX(queue[k]), z = Game::Grid::cellZ(queue[k]);
+        for (int d = 0; d < 4; d++)
+        {
+            int nx = x + DX[d], nz = z + DZ[d];
+            if (Rules::WRAP)
+            {
+                nx = (nx + Game::WIDTH) % Game::WIDTH;
+                nz = (nz + Game::HEIGHT) % Game::HEIGHT;
+            }
+            else if (nx < 0 || nx >= Game::WIDTH || nz < 0 || nz >= Game::HEIGHT)
+                continue;
+            int cell = Game::Grid::index(nx, nz);
+            if (!seen[cell] && open(cell))
+            {
+                seen[cell] = 1;
+                queue.push_back(cell);
+            }
+        }
+    }
+    reach.tailReachable = seen[tail] != 0;
+    reach.size = int(queue.size()) - (reach.tailReachable ? 1 : 0);
+    return reach;
+}
+
+template <class Rules>
+bool checkRules(const char *name, const char *sweep)
+{
+    typedef SnakeGame<Rules> Game;
+    static const int DX[4] = {0, 0, -1, 1};
+    static const int DZ[4] = {-1, 1, 0, 0};
+
+    std::unique_ptr<Game> game(new Game(4));
+    std::unique_ptr<ReachableArea<Rules>> area(new ReachableArea<Rules>());
+    Rng rng(5);
+    int fills = 0;
+    for (int t = 0; t < TICKS; t++)
+    {
+        if (game->step(pickMove(game->safeMoves(), rng)) == GAME_OVER)
+            game->reset();
+        area->update(*game);
+
+        int cells[8];
+        int count = 0;
+        const Segment &head = game->snake().head();
+        for (int d = 0; d < 4; d++)
+        {
+            int x = head.x + DX[d], z = head.z + DZ[d];
+            if (Rules::WRAP)
+            {
+                x = (x + Game::WIDTH) % Game::WIDTH;
+                z = (z + Game::HEIGHT) % Game::HEIGHT;
+            }
+            cells[count++] = Game::Grid::index(x, z);
+        }
+        while (count < 8)
+            cells[count++] = int(rng.below(Game::CELLS));
+
+        for (int k = 0; k < count; k++)
+        {
+            Reach got = area->from(cells[k], INT_MAX);
+            Reach want = naiveReach(*game, cells[k]);
+            if (got.size != want.size || got.tailReachable != want.tailReachable)
+            {
+                printf("FAIL %s %s: from cell %d after %d ticks: size %d tail %d, want %d tail %d\n", name, sweep,
+                       cells[k], t + 1, got.size, int(got.tailReachable), want.size, int(want.tailReachable));
+                return false;
+            }
+            fills++;
+        }
+    }
+    printf("ok   %s %s: %d fills\n", name, sweep, fills);
+    return true;
+}
+
+bool checkAll(const char *sweep)
+{
+    bool ok = true;
+    ok &= checkRules<ClassicRules>("classic", sweep);
+    ok &= checkRules<WrapRules>("wrap", sweep);
+    ok &= checkRules<AppleRainRules>("apple-rain", sweep);
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    floodSweepScalarOnly(true);
+    ok &= checkAll("scalar");
+    if (floodSweepScalarOnly(false))
+        ok &= checkAll("avx2");
+    else
+        printf("skip avx2: not supported by this CPU\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+// Checks Histogram against the exact order statistics of the values it
+// recorded: percentiles to within its 1/64 bucket precision, and merged
+// halves matching one histogram of everything.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "histogram.h"
+#include "rng.h"
+
+namespace
+{
+
+const double PERCENTILES[] = {0.1, 1, 10, 50, 90, 99, 99.9, 100};
+
+// Values spread over many magnitudes, small ones exact
+uint32_t sample(Rng &rng)
+{
+    uint32_t bits = rng.below(32);
+    return bits ? uint32_t(rng.next() & ((uint64_t(1) << bits) - 1)) : 0;
+}
+
+bool checkPercentiles()
+{
+    const int N = 200000;
+    Histogram all, low, high;
+    std::vector<uint32_t> values(N);
+    Rng rng(17);
+    for (int i = 0; i < N; i++)
+    {
+        values[i] = sample(rng);
+        all.record(values[i]);
+        (i < N / 2 ? low : high).record(values[i]);
+    }
+    low.merge(high);
+    std::sort(values.begin(), values.end());
+
+    if (all.count() != uint64_t(N) || all.min() != values.front() || all.max() != values.back())
+    {
+        printf("FAIL histogram: count, min or max\n");
+        return false;
+    }
+    for (double p : PERCENTILES)
+    {
+        size_t rank = size_t(p / 100.0 * N + 0.5);
+        uint32_t want = values[(rank ? rank : 1) - 1];
+        uint32_t got = all.percentile(p);
+        if (got < want || double(got - want) > double(want) / 64.0)
+        {
+            printf("FAIL histogram: p%g is %u, exact %u\n", p, got, want);
+            return false;
+        }
+        if (low.percentile(p) != got)
+        {
+            printf("FAIL histogram: p%g of merged halves is %u, not %u\n", p, low.percentile(p), got);
+            return false;
+        }
+    }
+    if (low.mean() != all.mean())
+    {
+        printf("FAIL histogram: merged mean\n");
+        return false;
+    }
+    printf("ok   histogram: %d values\n", N);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    return checkPercentiles() ? 0 : 1;
+}
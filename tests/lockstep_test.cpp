@@ -0,0 +1,175 @@
+// Plays BatchEnv and AsyncEnvPool game i against SnakeGame(seed + i) on
+// the same moves and checks they agree every tick: score, reward, done
+// flag, final score and position hash, under every pre-instantiated rule
+// set.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "async_env_pool.h"
+#include "batch_env.h"
+#include "observation.h"
+#include "rng.h"
+#include "snake_sim.h"
+#include "test_moves.h"
+
+namespace
+{
+
+const uint64_t SEED = 11;
+const int GAMES = 32;
+const int TICKS = 3000;
+
+// SnakeGame stepped the way the envs step theirs: reward +1 apple, -1
+// death, and a new round straight after a death
+template <class Rules>
+struct Reference
+{
+    SnakeGame<Rules> game;
+    float reward;
+    bool done;
+    int finalScore;
+
+    explicit Reference(uint64_t seed) : game(seed), reward(0.0f), done(false), finalScore(0) {}
+
+    void step(Direction dir)
+    {
+        int before = game.score();
+        done = game.step(dir) == GAME_OVER;
+        reward = done ? -1.0f : game.score() != before ? 1.0f : 0.0f;
+        if (done)
+        {
+            finalScore = game.score();
+            game.reset();
+        }
+    }
+};
+
+template <class Rules>
+bool checkBatch(const char *name)
+{
+    BatchEnv<Rules> env(GAMES, SEED);
+    std::vector<Reference<Rules>> refs;
+    for (int i = 0; i < GAMES; i++)
+        refs.emplace_back(SEED + uint64_t(i));
+    std::vector<uint8_t> actions(GAMES);
+    SnakeGame<Rules> copy;
+    Rng rng(3);
+
+    int deaths = 0;
+    for (int t = 0; t < TICKS; t++)
+    {
+        for (int i = 0; i < GAMES; i++)
+            actions[i] = uint8_t(pickMove(refs[i].game.safeMoves(), rng));
+        env.step(actions.data());
+        for (int i = 0; i < GAMES; i++)
+        {
+            Reference<Rules> &ref = refs[i];
+            ref.step(Direction(actions[i]));
+            env.copyGame(i, copy);
+            bool done = env.dones()[i] != 0;
+            if (env.scores()[i] != ref.game.score() || env.rewards()[i] != ref.reward || done != ref.done ||
+                (done && env.finalScores()[i] != ref.finalScore) || copy.hash() != ref.game.hash() ||
+                env.tick(i) != ref.game.tick() || env.episode(i) != ref.game.episode())
+            {
+                printf("FAIL %s BatchEnv: game %d differs at tick %d\n", name, i, t);
+                return false;
+            }
+            deaths += done;
+        }
+    }
+    printf("ok   %s BatchEnv: %d games, %d ticks, %d deaths\n", name, GAMES, TICKS, deaths);
+    return true;
+}
+
+// Sends a quarter of the games at a time, so results come back out of
+// order and games drift apart in ticks
+template <class Rules>
+bool checkAsync(const char *name)
+{
+    typedef typename SnakeGame<Rules>::Grid Grid;
+    const int BATCH = GAMES / 4;
+
+    AsyncEnvPool<Rules> pool(GAMES, SEED, 2);
+    std::vector<Reference<Rules>> refs;
+    for (int i = 0; i < GAMES; i++)
+        refs.emplace_back(SEED + uint64_t(i));
+    std::vector<int32_t> ids(GAMES);
+    std::vector<uint8_t> actions(GAMES), sent(GAMES);
+    std::vector<uint8_t> observation(Grid::CELLS);
+    Rng rng(3);
+
+    if (!pool.reset() || pool.recv(ids.data(), GAMES) != GAMES)
+    {
+        printf("FAIL %s AsyncEnvPool: reset\n", name);
+        return false;
+    }
+    for (int i = 0; i < GAMES; i++)
+    {
+        refs[i].game.reset();
+        ids[i] = i;
+        sent[i] = uint8_t(pickMove(refs[i].game.safeMoves(), rng));
+    }
+    if (!pool.send(ids.data(), sent.data(), GAMES))
+    {
+        printf("FAIL %s AsyncEnvPool: send\n", name);
+        return false;
+    }
+
+    int deaths = 0;
+    for (int r = 0; r < TICKS * GAMES / BATCH; r++)
+    {
+        pool.recv(ids.data(), BATCH);
+        for (int k = 0; k < BATCH; k++)
+        {
+            int id = ids[k];
+            Reference<Rules> &ref = refs[id];
+            ref.step(Direction(sent[id]));
+            const SnakeGame<Rules> &game = pool.game(id);
+
+            memcpy(observation.data(), ref.game.cells().data(), Grid::CELLS);
+            const Segment &head = ref.game.snake().head();
+            observation[Grid::index(head.x, head.z)] = OBS_CELL_HEAD;
+
+            if (game.score() != ref.game.score() || pool.reward(id) != ref.reward || pool.done(id) != ref.done ||
+                (ref.done && pool.finalScore(id) != ref.finalScore) || game.hash() != ref.game.hash() ||
+                game.tick() != ref.game.tick() || memcmp(pool.observation(id), observation.data(), Grid::CELLS) != 0)
+            {
+                printf("FAIL %s AsyncEnvPool: game %d differs after %d ticks\n", name, id, ref.game.tick());
+                return false;
+            }
+            deaths += ref.done;
+            sent[id] = uint8_t(pickMove(ref.game.safeMoves(), rng));
+            actions[k] = sent[id];
+        }
+        if (!pool.send(ids.data(), actions.data(), BATCH))
+        {
+            printf("FAIL %s AsyncEnvPool: send\n", name);
+            return false;
+        }
+    }
+    // Drain before the pool goes; asking for more than are in flight
+    // returns what there is
+    if (pool.recv(ids.data(), GAMES + 1) != GAMES || pool.recv(ids.data(), 1) != 0)
+    {
+        printf("FAIL %s AsyncEnvPool: drain\n", name);
+        return false;
+    }
+    printf("ok   %s AsyncEnvPool: %d games, %d steps, %d deaths\n", name, GAMES, TICKS * GAMES, deaths);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= checkBatch<ClassicRules>("classic");
+    ok &= checkBatch<WrapRules>("wrap");
+    ok &= checkBatch<AppleRainRules>("apple-rain");
+    ok &= checkAsync<ClassicRules>("classic");
+    ok &= checkAsync<WrapRules>("wrap");
+    ok &= checkAsync<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
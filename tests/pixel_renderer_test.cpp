@@ -0,0 +1,88 @@
+// Checks PixelRenderer: frames rendered in parallel from a BatchEnv match
+// rendering each game on its own, forRules() matches a renderer built
+// from a game's own grid, and the snake shows up in the frame.
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "batch_env.h"
+#include "pixel_renderer.h"
+#include "rng.h"
+#include "snake_sim.h"
+#include "test_moves.h"
+#include "work_stealing_pool.h"
+
+namespace
+{
+
+const int GAMES = 16;
+const int TICKS = 200;
+const int FRAME = 84;
+
+template <class Rules>
+bool checkRules(const char *name)
+{
+    typedef SnakeGame<Rules> Game;
+    PixelRenderer renderer = PixelRenderer::forRules<Rules>(FRAME);
+    std::unique_ptr<Game> game(new Game(3));
+    PixelRenderer fromGame(game->cells().data(), Rules::WIDTH, Rules::HEIGHT, FRAME);
+
+    const size_t bytes = size_t(renderer.frameBytes());
+    std::vector<uint8_t> frames(GAMES * bytes), one(bytes), other(bytes);
+    renderer.render(*game, one.data());
+    fromGame.render(*game, other.data());
+    if (memcmp(one.data(), other.data(), bytes) != 0)
+    {
+        printf("FAIL %s: forRules() frame differs from a renderer built from the game\n", name);
+        return false;
+    }
+
+    // Walls alone against the same board with the snake and apples on it
+    const typename Game::Grid &walls = Game::wallGrid();
+    renderer.render(walls.data(), -1, other.data());
+    if (memcmp(one.data(), other.data(), bytes) == 0)
+    {
+        printf("FAIL %s: the snake and apples don't show in the frame\n", name);
+        return false;
+    }
+
+    WorkStealingPool pool(4);
+    BatchEnv<Rules> env(GAMES, 5);
+    std::vector<uint8_t> actions(GAMES);
+    Rng rng(6);
+    for (int t = 0; t < TICKS; t++)
+    {
+        for (int i = 0; i < GAMES; i++)
+        {
+            env.copyGame(i, *game);
+            actions[i] = uint8_t(pickMove(game->safeMoves(), rng));
+        }
+        env.step(actions.data());
+        renderBatch(pool, renderer, env, frames.data());
+        for (int i = 0; i < GAMES; i++)
+        {
+            env.copyGame(i, *game);
+            renderer.render(*game, one.data());
+            if (memcmp(one.data(), frames.data() + size_t(i) * bytes, bytes) != 0)
+            {
+                printf("FAIL %s: batch frame of game %d differs after %d ticks\n", name, i, t + 1);
+                return false;
+            }
+        }
+    }
+    printf("ok   %s: %d batch frames\n", name, GAMES * TICKS);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= checkRules<ClassicRules>("classic");
+    ok &= checkRules<WrapRules>("wrap");
+    ok &= checkRules<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
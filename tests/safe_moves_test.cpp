@@ -0,0 +1,88 @@
+// Checks the time-to-free index: safeMoves() against stepping a copy of
+// the game each way, and ticksUntilFree() against counting along the body,
+// every tick of random play under every pre-instantiated rule set.
+
+#include <cstdio>
+#include <memory>
+
+#include "rng.h"
+#include "snake_sim.h"
+#include "test_moves.h"
+
+namespace
+{
+
+const int TICKS = 20000;
+
+// Ticks until the tail pops off each body cell, counted from the tail,
+// with the growth still owed (from parts) paid first
+template <class Rules>
+bool checkTicksUntilFree(const SnakeGame<Rules> &game, typename SnakeGame<Rules>::Parts &parts, const char *name)
+{
+    typedef SnakeGame<Rules> Game;
+    game.save(parts);
+    const typename Game::Body &body = game.snake();
+    for (size_t k = 0; k < body.size(); k++)
+    {
+        int cell = Game::Grid::index(body[k].x, body[k].z);
+        int want = int(body.size() - 1 - k) + 1 + parts.pendingGrowth;
+        if (game.ticksUntilFree(cell) != want)
+        {
+            printf("FAIL %s ticksUntilFree: segment %d of %d after %d ticks: %d, want %d\n", name, int(k),
+                   int(body.size()), game.tick(), game.ticksUntilFree(cell), want);
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Rules>
+bool checkRules(const char *name)
+{
+    typedef SnakeGame<Rules> Game;
+    std::unique_ptr<Game> game(new Game(8)), copy(new Game(0));
+    std::unique_ptr<typename Game::Parts> parts(new typename Game::Parts);
+    Rng rng(9);
+    int deaths = 0;
+    for (int t = 0; t < TICKS; t++)
+    {
+        unsigned safe = game->safeMoves();
+        for (int d = 0; d < 4; d++)
+        {
+            // A reversal is ignored by step(), so it never counts as safe
+            bool survives = d != (game->direction() ^ 1);
+            if (survives)
+            {
+                *copy = *game;
+                survives = copy->step(Direction(d)) == PLAYING;
+            }
+            if (((safe >> d) & 1) != unsigned(survives))
+            {
+                printf("FAIL %s safeMoves: direction %d after %d ticks: safe %d, survives %d\n", name, d, t,
+                       int((safe >> d) & 1), int(survives));
+                return false;
+            }
+        }
+        if (!checkTicksUntilFree(*game, *parts, name))
+            return false;
+
+        if (game->step(pickMove(safe, rng)) == GAME_OVER)
+        {
+            game->reset();
+            deaths++;
+        }
+    }
+    printf("ok   %s: %d ticks, %d deaths\n", name, TICKS, deaths);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= checkRules<ClassicRules>("classic");
+    ok &= checkRules<WrapRules>("wrap");
+    ok &= checkRules<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
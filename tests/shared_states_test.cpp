@@ -0,0 +1,110 @@
+// Checks publishing through SharedStates: a game read back from a slot
+// (state, score, high score, position) plays on exactly as the original,
+// a finished game stays finished, and a slot holding malformed parts is
+// refused with the reader's game left alone.
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <unistd.h>
+
+#include "rng.h"
+#include "shared_states.h"
+#include "snake_sim.h"
+#include "test_moves.h"
+
+namespace
+{
+
+const int TICKS = 2000;
+
+template <class Rules>
+bool same(const SnakeGame<Rules> &a, const SnakeGame<Rules> &b)
+{
+    return a.hash() == b.hash() && a.state() == b.state() && a.score() == b.score() &&
+           a.highScore() == b.highScore() && a.tick() == b.tick() && a.episode() == b.episode();
+}
+
+template <class Rules>
+bool checkRules(const char *name)
+{
+    typedef SnakeGame<Rules> Game;
+    char region[64];
+    snprintf(region, sizeof(region), "snake_test_%d_%s", int(getpid()), name);
+    SharedStates writer, reader;
+    if (!writer.create<Rules>(region, 2) || !reader.open(region) || !reader.holds<Rules>())
+    {
+        printf("FAIL %s: can't set up region %s\n", name, region);
+        return false;
+    }
+
+    std::unique_ptr<Game> game(new Game(31)), seen(new Game(0));
+    Rng rng(32);
+    int32_t id = -1;
+    int finished = 0;
+    for (int t = 0; t < TICKS; t++)
+    {
+        Direction move = pickMove(game->safeMoves(), rng);
+        bool over = game->step(move) == GAME_OVER;
+        writer.publish(0, t, *game);
+        if (!reader.read(0, id, *seen) || id != t || !same(*seen, *game))
+        {
+            printf("FAIL %s: slot read back differs after %d ticks\n", name, t + 1);
+            return false;
+        }
+        if (over)
+        {
+            finished++;
+            game->reset();
+        }
+        else
+        {
+            // The reader's copy plays on like the original
+            Direction next = pickMove(game->safeMoves(), rng);
+            std::unique_ptr<Game> ahead(new Game(*game));
+            ahead->step(next);
+            seen->step(next);
+            if (!same(*seen, *ahead))
+            {
+                printf("FAIL %s: read-back game plays differently after %d ticks\n", name, t + 1);
+                return false;
+            }
+        }
+    }
+
+    // Malformed parts: a body segment off the board, then a bad cell type
+    std::unique_ptr<typename Game::Parts> parts(new typename Game::Parts);
+    game->save(*parts);
+    parts->body.popTail();
+    parts->body.pushHead({int16_t(Game::WIDTH), 0});
+    writer.publish(1, 7, static_cast<const void *>(parts.get()));
+    uint64_t before = seen->hash();
+    if (reader.read(1, id, *seen) || seen->hash() != before)
+    {
+        printf("FAIL %s: a body segment off the board was accepted\n", name);
+        return false;
+    }
+    game->save(*parts);
+    parts->grid.set(0, CellType(9));
+    writer.publish(1, 8, static_cast<const void *>(parts.get()));
+    if (reader.read(1, id, *seen) || seen->hash() != before)
+    {
+        printf("FAIL %s: a bad cell type was accepted\n", name);
+        return false;
+    }
+
+    printf("ok   %s: %d ticks, %d finished games\n", name, TICKS, finished);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= checkRules<ClassicRules>("classic");
+    ok &= checkRules<WrapRules>("wrap");
+    ok &= checkRules<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
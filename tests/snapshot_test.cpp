@@ -0,0 +1,68 @@
+// Checks snapshots: a game restored from a snapshot replays the same moves
+// exactly as it went the first time (position, score and the apples its
+// generator spawns), under every pre-instantiated rule set.
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "rng.h"
+#include "snake_sim.h"
+#include "test_moves.h"
+
+namespace
+{
+
+const int ROUNDS = 200;
+const int SPAN = 100; // Ticks replayed from each snapshot
+
+template <class Rules>
+bool checkRules(const char *name)
+{
+    typedef SnakeGame<Rules> Game;
+    std::unique_ptr<Game> game(new Game(21));
+    std::unique_ptr<typename Game::Snapshot> snapshot(new typename Game::Snapshot);
+    std::vector<Direction> moves(SPAN);
+    std::vector<uint64_t> hashes(SPAN);
+    std::vector<int> scores(SPAN);
+    Rng rng(22);
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        game->save(*snapshot);
+        for (int t = 0; t < SPAN; t++)
+        {
+            moves[t] = pickMove(game->safeMoves(), rng);
+            GameState state = game->step(moves[t]);
+            hashes[t] = game->hash();
+            scores[t] = game->score();
+            if (state == GAME_OVER)
+                game->reset();
+        }
+
+        game->restore(*snapshot);
+        for (int t = 0; t < SPAN; t++)
+        {
+            GameState state = game->step(moves[t]);
+            if (game->hash() != hashes[t] || game->score() != scores[t])
+            {
+                printf("FAIL %s: replay from snapshot %d differs after %d ticks\n", name, r, t + 1);
+                return false;
+            }
+            if (state == GAME_OVER)
+                game->reset();
+        }
+    }
+    printf("ok   %s: %d snapshots, %d ticks each\n", name, ROUNDS, SPAN);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    bool ok = true;
+    ok &= checkRules<ClassicRules>("classic");
+    ok &= checkRules<WrapRules>("wrap");
+    ok &= checkRules<AppleRainRules>("apple-rain");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Move choice shared by the tests
+
+#include <cstdint>
+
+#include "rng.h"
+#include "sim_types.h"
+
+// Mostly a random safe move, so games run long enough to grow; otherwise
+// any move, so they also die
+inline Direction pickMove(unsigned safe, Rng &rng)
+{
+    if (!safe || rng.below(8) == 0)
+        return Direction(rng.below(4));
+    for (uint32_t k = rng.below(uint32_t(__builtin_popcount(safe))); k > 0; k--)
+        safe &= safe - 1;
+    return Direction(__builtin_ctz(safe));
+}
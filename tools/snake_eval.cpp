@@ -0,0 +1,255 @@
+// Batch policy evaluation: plays M episodes over a seed range on every
+// core and prints score, length and tick percentiles, death causes and
+// throughput. Results stream into per-thread histograms that are merged
+// at the end, so no episode is stored.
+//
+//     snake_eval [--rules classic|wrap|apple-rain] [--policy random|greedy|bfs|mcts]
+//                [--policy-lib file.so] [--episodes M] [--seed S]
+//                [--max-ticks T] [--threads N] [--budget-ms B] [--table-mb S]
+//
+// mcts searches for B ms per move (default 10) on the worker playing the
+// episode, with an S MB transposition table if S > 0; episodes still run
+// in parallel. M and N must be whole numbers above zero.
+
+#include <dlfcn.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "autopilot.h"
+#include "episode_runner.h"
+#include "histogram.h"
+#include "mcts.h"
+#include "observation.h"
+#include "snake_c.h"
+
+namespace
+{
+
+struct Options
+{
+    std::string rules = "classic";
+    std::string policy = "greedy";
+    std::string policyLib;
+    uint64_t episodes = 100000;
+    uint64_t seed = 1;
+    int maxTicks = 10000;
+    unsigned threads = 0;
+    int budgetMs = 10;
+    int tableMb = 0;
+};
+
+// One worker's running totals; merged once the run is over
+struct alignas(64) EvalStats
+{
+    Histogram score, length, ticks;
+    uint64_t deaths[3] = {0, 0, 0}; // By DeathCause; DEATH_NONE = tick limit
+
+    void add(const EpisodeResult &r)
+    {
+        score.record(uint32_t(r.score));
+        length.record(uint32_t(r.length));
+        ticks.record(uint32_t(r.ticks));
+        deaths[r.cause]++;
+    }
+
+    void merge(const EvalStats &other)
+    {
+        score.merge(other.score);
+        length.merge(other.length);
+        ticks.merge(other.ticks);
+        for (int i = 0; i < 3; i++)
+            deaths[i] += other.deaths[i];
+    }
+};
+
+// A policy from a shared library (see snake_c.h), fed the grid
+// observation. Each worker's copy has its own observation buffer.
+struct LibraryPolicy
+{
+    snake_policy_act_fn act;
+    std::vector<uint8_t> cells;
+
+    void reset(uint64_t) {}
+
+    template <class Rules>
+    Direction operator()(const SnakeGame<Rules> &game)
+    {
+        typedef SnakeGame<Rules> Game;
+        cells.resize(Game::CELLS);
+        std::memcpy(cells.data(), game.cells().data(), Game::CELLS);
+        const Segment &head = game.snake().head();
+        cells[Game::Grid::index(head.x, head.z)] = OBS_CELL_HEAD;
+        return Direction(act(cells.data(), Game::WIDTH, Game::HEIGHT, game.direction()) & 3);
+    }
+};
+
+void printRow(const char *name, const Histogram &h)
+{
+    printf("%-8s %9.2f %7u %7u %7u %7u %7u %7u\n", name, h.mean(), h.min(), h.percentile(50), h.percentile(90),
+           h.percentile(99), h.percentile(99.9), h.max());
+}
+
+template <class Rules, class Policy>
+int evaluate(const Options &options, const Policy &policy)
+{
+    WorkStealingPool pool(options.threads);
+    std::vector<EvalStats> stats(pool.size());
+    auto sink = [&](const EpisodeResult &r, unsigned worker) { stats[worker].add(r); };
+
+    auto start = std::chrono::steady_clock::now();
+    runEpisodes<Rules>(pool, policy, options.seed, options.episodes, options.maxTicks, sink);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EvalStats total;
+    for (const EvalStats &s : stats)
+        total.merge(s);
+
+    uint64_t n = total.score.count();
+    double ticks = total.ticks.mean() * double(n);
+    printf("%s, policy %s: %llu episodes (seeds %llu..%llu) on %u threads\n", options.rules.c_str(),
+           options.policyLib.empty() ? options.policy.c_str() : options.policyLib.c_str(), (unsigned long long)n,
+           (unsigned long long)options.seed, (unsigned long long)(options.seed + n - 1), pool.size());
+    printf("%.2f s, %.0f episodes/s, %.2fM ticks/s\n\n", seconds, double(n) / seconds, ticks / seconds / 1e6);
+    printf("%-8s %9s %7s %7s %7s %7s %7s %7s\n", "", "mean", "min", "p50", "p90", "p99", "p99.9", "max");
+    printRow("score", total.score);
+    printRow("length", total.length);
+    printRow("ticks", total.ticks);
+    printf("\ndeaths: wall %.1f%%, self %.1f%%, tick limit %.1f%%\n", 100.0 * double(total.deaths[DEATH_WALL]) / double(n),
+           100.0 * double(total.deaths[DEATH_SELF]) / double(n), 100.0 * double(total.deaths[DEATH_NONE]) / double(n));
+    return 0;
+}
+
+template <class Rules>
+int evaluate(const Options &options)
+{
+    if (!options.policyLib.empty())
+    {
+        void *lib = dlopen(options.policyLib.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!lib)
+        {
+            fprintf(stderr, "snake_eval: %s\n", dlerror());
+            return 1;
+        }
+        LibraryPolicy policy;
+        policy.act = reinterpret_cast<snake_policy_act_fn>(dlsym(lib, "snake_policy_act"));
+        if (!policy.act)
+        {
+            fprintf(stderr, "snake_eval: %s has no snake_policy_act\n", options.policyLib.c_str());
+            return 1;
+        }
+        return evaluate<Rules>(options, policy);
+    }
+    if (options.policy == "random")
+        return evaluate<Rules>(options, RandomPolicy());
+    if (options.policy == "greedy")
+        return evaluate<Rules>(options, GreedyPolicy());
+    if (options.policy == "bfs")
+        return evaluate<Rules>(options, BfsAutopilot<Rules>());
+    if (options.policy == "mcts")
+    {
+        MctsConfig config;
+        config.budgetMs = options.budgetMs;
+        config.nodes = 1 << 17; // A copy per worker, and short searches
+        config.tableBytes = size_t(options.tableMb) << 20;
+        return evaluate<Rules>(options, MctsAutopilot<Rules>(config));
+    }
+    fprintf(stderr, "snake_eval: unknown policy %s\n", options.policy.c_str());
+    return 1;
+}
+
+// A whole number above zero, digits only; false for anything else
+bool parsePositive(const char *text, uint64_t &out)
+{
+    if (*text < '0' || *text > '9')
+        return false;
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value == 0)
+        return false;
+    out = value;
+    return true;
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: snake_eval [--rules classic|wrap|apple-rain] [--policy random|greedy|bfs|mcts]\n"
+                    "                  [--policy-lib file.so] [--episodes M] [--seed S]\n"
+                    "                  [--max-ticks T] [--threads N] [--budget-ms B] [--table-mb S]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            usage();
+            return 1;
+        }
+        if (strcmp(arg, "--rules") == 0)
+            options.rules = value;
+        else if (strcmp(arg, "--policy") == 0)
+            options.policy = value;
+        else if (strcmp(arg, "--policy-lib") == 0)
+            options.policyLib = value;
+        else if (strcmp(arg, "--episodes") == 0)
+        {
+            if (!parsePositive(value, options.episodes))
+            {
+                usage();
+                return 1;
+            }
+        }
+        else if (strcmp(arg, "--seed") == 0)
+            options.seed = strtoull(value, nullptr, 10);
+        else if (strcmp(arg, "--max-ticks") == 0)
+            options.maxTicks = atoi(value);
+        else if (strcmp(arg, "--threads") == 0)
+        {
+            uint64_t threads;
+            if (!parsePositive(value, threads) || threads > UINT32_MAX)
+            {
+                usage();
+                return 1;
+            }
+            options.threads = unsigned(threads);
+        }
+        else if (strcmp(arg, "--budget-ms") == 0)
+            options.budgetMs = atoi(value);
+        else if (strcmp(arg, "--table-mb") == 0)
+            options.tableMb = atoi(value);
+        else
+        {
+            usage();
+            return 1;
+        }
+        i++;
+    }
+    if (options.episodes > UINT32_MAX)
+    {
+        fprintf(stderr, "snake_eval: --episodes must be below 2^32\n");
+        return 1;
+    }
+
+    if (options.rules == "classic")
+        return evaluate<ClassicRules>(options);
+    if (options.rules == "wrap")
+        return evaluate<WrapRules>(options);
+    if (options.rules == "apple-rain")
+        return evaluate<AppleRainRules>(options);
+    usage();
+    return 1;
+}